@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file JobBenchmark.cpp
+/// @brief A benchmark of the job system.
+///
+/// This file contains a standalone program that measures how the job system
+/// scales with the number of workers: the throughput of empty jobs, of a graph
+/// of jobs that fan out and back in through their dependencies, and of
+/// generating terrain chunks. It is built by the cambre_job_bench target when
+/// CAMBRE_BUILD_BENCHMARKS is enabled.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "Chunk.hpp"
+#include "JobSystem.hpp"
+#include "TerrainGenerator.hpp"
+
+static const int EMPTY_JOBS = 200000;
+
+// The number of independent jobs between the root and the final job of each
+// graph, and the number of graphs.
+static const int GRAPH_WIDTH = 64;
+static const int GRAPH_COUNT = 2000;
+
+// The chunks generated per run are the columns of a square, from the bottom to
+// the top of the terrain.
+static const int TERRAIN_WIDTH = 24;
+static const int TERRAIN_BOTTOM = -4;
+static const int TERRAIN_TOP = 4;
+
+// The largest number of workers measured.
+static const unsigned int MAX_WORKERS = 32;
+
+static double elapsed(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+    return seconds.count();
+}
+
+// Submits jobs that do nothing, from the main thread, and waits for them. This
+// measures the overhead of queueing, stealing and finishing a job.
+static double runEmptyJobs(JobSystem &jobs)
+{
+    std::atomic<int> count(0);
+    std::vector<JobSystem::JobHandle> handles;
+    handles.reserve(EMPTY_JOBS);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int i = 0; i < EMPTY_JOBS; i++)
+    {
+        handles.push_back(jobs.submit([&count](void) {
+            count++;
+        }));
+    }
+
+    JobSystem::JobHandle done = jobs.submit([](void) {}, handles);
+    jobs.wait(done);
+
+    return EMPTY_JOBS / elapsed(start);
+}
+
+// Runs graphs that fan out from a root job into independent jobs, which are
+// joined by a final job, followed by a continuation on the main thread.
+static double runGraphs(JobSystem &jobs)
+{
+    std::atomic<long> sum(0);
+    int finished = 0;
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int g = 0; g < GRAPH_COUNT; g++)
+    {
+        JobSystem::JobHandle root = jobs.submit([](void) {});
+
+        std::vector<JobSystem::JobHandle> branches;
+        for (int i = 0; i < GRAPH_WIDTH; i++)
+        {
+            branches.push_back(jobs.then(root, [&sum, i](void) {
+                sum += i;
+            }));
+        }
+
+        JobSystem::JobHandle join = jobs.submit([](void) {}, branches);
+        jobs.then(join, [&finished](void) {
+            finished++;
+        }, JobSystem::MAIN_THREAD);
+    }
+
+    while (finished < GRAPH_COUNT)
+    {
+        if (!jobs.runMainThreadJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    return GRAPH_COUNT * (GRAPH_WIDTH + 2) / elapsed(start);
+}
+
+// Generates a square of chunk columns with a fresh generator, so that every
+// run fills its own column cache.
+static double runTerrain(JobSystem &jobs)
+{
+    TerrainGenerator generator;
+    std::vector<JobSystem::JobHandle> handles;
+    int chunks = TERRAIN_WIDTH * TERRAIN_WIDTH *
+        (TERRAIN_TOP - TERRAIN_BOTTOM + 1);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int x = 0; x < TERRAIN_WIDTH; x++)
+    {
+        for (int z = 0; z < TERRAIN_WIDTH; z++)
+        {
+            for (int y = TERRAIN_BOTTOM; y <= TERRAIN_TOP; y++)
+            {
+                glm::ivec3 coords(x, y, z);
+                handles.push_back(jobs.submit([&generator, coords](void) {
+                    BlockId blocks[Chunk::BLOCK_COUNT];
+                    generator.generate(coords, blocks);
+                }));
+            }
+        }
+    }
+
+    JobSystem::JobHandle done = jobs.submit([](void) {}, handles);
+    jobs.wait(done);
+
+    return chunks / elapsed(start);
+}
+
+int main(void)
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::cout << "Measuring up to " << MAX_WORKERS << " workers on "
+        << threads << " hardware threads" << std::endl;
+
+    for (unsigned int workers = 1; workers <= MAX_WORKERS; workers *= 2)
+    {
+        JobSystem jobs(workers);
+
+        double empty = runEmptyJobs(jobs);
+        double graphs = runGraphs(jobs);
+        double terrain = runTerrain(jobs);
+
+        std::cout << workers << " workers: " << empty << " empty jobs/s, "
+            << graphs << " graph jobs/s, " << terrain << " chunks/s"
+            << std::endl;
+        jobs.printStatistics();
+    }
+
+    return 0;
+}
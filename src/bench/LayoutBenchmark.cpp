@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file LayoutBenchmark.cpp
+/// @brief A benchmark comparing the voxel layouts.
+///
+/// This file contains a standalone program that interns a chunk in a
+/// BlockStore and times the workloads that depend on the order of the blocks:
+/// neighbor queries, face visibility tests and the gather of a padded volume
+/// followed by meshing. The store uses the layout it is compiled with, so the
+/// program is built once per layout, by the cambre_layout_bench_<layout>
+/// targets when CAMBRE_BUILD_BENCHMARKS is enabled.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Block.hpp"
+#include "BlockStore.hpp"
+#include "Chunk.hpp"
+#include "ChunkMesher.hpp"
+
+static const int SIZE_X = Chunk::CHUNK_SIZE_X;
+static const int SIZE_Y = Chunk::CHUNK_SIZE_Y;
+static const int SIZE_Z = Chunk::CHUNK_SIZE_Z;
+static const int BLOCK_COUNT = Chunk::BLOCK_COUNT;
+
+static const int ITERATIONS = 2000;
+
+// The offsets of the neighboring block in each direction.
+static const int NEIGHBOR_OFFSET[6][3] = {
+    { 1,  0,  0},
+    {-1,  0,  0},
+    { 0,  1,  0},
+    { 0, -1,  0},
+    { 0,  0,  1},
+    { 0,  0, -1}
+};
+
+// Fills blocks indexed by [x][y][z] with rolling stone terrain, a few pockets
+// of glass and a pool of water, so that every workload sees mixed content.
+static void generateTerrain(std::vector<BlockId> &blocks)
+{
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> pocket(0, 31);
+
+    blocks.assign(BLOCK_COUNT, Block::AIR);
+    for (int x = 0; x < SIZE_X; x++)
+    {
+        for (int z = 0; z < SIZE_Z; z++)
+        {
+            int height = 6 + ((x * 3 + z * 5) % 7);
+            for (int y = 0; y < SIZE_Y; y++)
+            {
+                BlockId type = Block::AIR;
+                if (y < height)
+                {
+                    type = (pocket(random) == 0) ? Block::GLASS : Block::STONE;
+                }
+                else if (y < 9)
+                {
+                    type = Block::WATER;
+                }
+
+                blocks[BlockArrayLayout::index(x, y, z)] = type;
+            }
+        }
+    }
+}
+
+static double elapsed(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+    return seconds.count();
+}
+
+// Visits every block in storage order and reads its six neighbors. This is the
+// access pattern of lighting and physics queries.
+static unsigned long queryNeighbors(const BlockStore &blocks)
+{
+    unsigned long solid = 0;
+    for (int i = 0; i < BLOCK_COUNT; i++)
+    {
+        int x, y, z;
+        BlockLayout::coords(i, x, y, z);
+
+        for (int dir = 0; dir < 6; dir++)
+        {
+            int nx = x + NEIGHBOR_OFFSET[dir][0];
+            int ny = y + NEIGHBOR_OFFSET[dir][1];
+            int nz = z + NEIGHBOR_OFFSET[dir][2];
+            if (nx < 0 || ny < 0 || nz < 0 ||
+                nx >= SIZE_X || ny >= SIZE_Y || nz >= SIZE_Z)
+            {
+                continue;
+            }
+
+            solid += Block::isSolid(blocks.getBlock(nx, ny, nz));
+        }
+    }
+
+    return solid;
+}
+
+// Counts the visible faces inside the chunk, as the naive mesher would.
+static unsigned long countFaces(const BlockStore &blocks)
+{
+    unsigned long faces = 0;
+    for (int i = 0; i < BLOCK_COUNT; i++)
+    {
+        int x, y, z;
+        BlockLayout::coords(i, x, y, z);
+        BlockId type = blocks.getBlock(x, y, z);
+
+        for (int dir = 0; dir < 6; dir++)
+        {
+            int nx = x + NEIGHBOR_OFFSET[dir][0];
+            int ny = y + NEIGHBOR_OFFSET[dir][1];
+            int nz = z + NEIGHBOR_OFFSET[dir][2];
+            BlockId neighbor = Block::AIR;
+            if (nx >= 0 && ny >= 0 && nz >= 0 &&
+                nx < SIZE_X && ny < SIZE_Y && nz < SIZE_Z)
+            {
+                neighbor = blocks.getBlock(nx, ny, nz);
+            }
+
+            faces += Block::isFaceVisible(type, neighbor);
+        }
+    }
+
+    return faces;
+}
+
+// Gathers the blocks into a padded volume and meshes it, as Chunk::gatherVolume
+// and the mesh workers do.
+static unsigned long gatherAndMesh(const BlockStore &blocks,
+    ChunkMesher &mesher, std::vector<BlockId> &volume,
+    std::vector<uint32_t> &vertices)
+{
+    blocks.copyToVolume(volume.data());
+
+    mesher.mesh(volume.data(), vertices);
+    return vertices.size();
+}
+
+int main(void)
+{
+    std::vector<BlockId> terrain;
+    generateTerrain(terrain);
+
+    std::cout << "Timing " << ITERATIONS << " iterations per workload on a "
+        << SIZE_X << "x" << SIZE_Y << "x" << SIZE_Z << " chunk" << std::endl;
+
+    std::shared_ptr<const BlockStore> store =
+        BlockStore::intern(terrain.data());
+    const BlockStore &blocks = *store;
+    std::vector<BlockId> volume(Chunk::VOLUME_BLOCK_COUNT, Block::AIR);
+    std::vector<uint32_t> vertices;
+    ChunkMesher mesher;
+    unsigned long checksum = 0;
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        checksum += queryNeighbors(blocks);
+    }
+    double neighborSeconds = elapsed(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        checksum += countFaces(blocks);
+    }
+    double faceSeconds = elapsed(start);
+
+    double meshSeconds[ChunkMesher::MAX_MESHING_MODE];
+    for (int mode = 0; mode < ChunkMesher::MAX_MESHING_MODE; mode++)
+    {
+        mesher.setMode(static_cast<ChunkMesher::MeshingModeEnum>(mode));
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            checksum += gatherAndMesh(blocks, mesher, volume, vertices);
+        }
+        meshSeconds[mode] = elapsed(start);
+    }
+
+    const double scale = 1000000.0 / ITERATIONS;
+    std::cout << BlockLayout::getName() << " Layout: "
+        << neighborSeconds * scale << " us neighbors, "
+        << faceSeconds * scale << " us faces, "
+        << meshSeconds[ChunkMesher::NAIVE] * scale << " us naive, "
+        << meshSeconds[ChunkMesher::GREEDY] * scale << " us greedy, "
+        << meshSeconds[ChunkMesher::BITMASK] * scale << " us bitmask"
+        << " (checksum " << checksum << ")" << std::endl;
+
+    return 0;
+}
@@ -20,6 +20,7 @@ static const float LOOK_SPEED = 0.25;
 CameraController::CameraController(void)
 {
     mEventStates.resize(AE_MAX_EVENT_ENUM);
+    mVelocity = glm::vec3(0);
 }
 
 void CameraController::registerWith(InputManager &manager)
@@ -53,7 +54,9 @@ void CameraController::onEvent(ApplicationEventStruct event)
 
 void CameraController::update(void)
 {
+    glm::vec3 position = mCamera.getPosition();
     updatePosition();
+    mVelocity = mCamera.getPosition() - position;
     updateFacing();
 }
 
@@ -67,6 +70,16 @@ glm::vec3 CameraController::getPosition(void)
     return mCamera.getPosition();
 }
 
+glm::vec3 CameraController::getFacing(void)
+{
+    return mCamera.getFacing();
+}
+
+glm::vec3 CameraController::getVelocity(void)
+{
+    return mVelocity;
+}
+
 void CameraController::updatePosition(void)
 {
     glm::vec3 position = mCamera.getPosition();
@@ -24,12 +24,17 @@ public:
     void update(void);
     glm::mat4 getView(void);
     glm::vec3 getPosition(void);
+    glm::vec3 getFacing(void);
+
+    /// @brief Gets the distance the camera moved during the last update.
+    glm::vec3 getVelocity(void);
 
 private:
     Camera mCamera;
     std::vector<ApplicationEventType> mEventStates;
     ApplicationEventDataStruct mCursorData;
     ApplicationEventDataStruct mPrevCursorData;
+    glm::vec3 mVelocity;
 
     void updatePosition(void);
     void updateFacing(void);
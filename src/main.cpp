@@ -16,6 +16,7 @@ int main()
 
     r.useShader(shader);
     r.useCameraController(cc);
+    r.useSaveDirectory("./world");
     r.registerWith(manager);
 
     app.registerInputs(manager);
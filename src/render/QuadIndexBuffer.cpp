@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file QuadIndexBuffer.cpp
+/// @brief A shared index buffer for drawing quads.
+///
+/// This file contains the QuadIndexBuffer class. It owns a single OpenGL index
+/// buffer that turns every four vertices into the two triangles of a quad, so
+/// that any mesh made of quads can be drawn without its own index buffer.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "QuadIndexBuffer.hpp"
+
+GLuint QuadIndexBuffer::mIbo = 0;
+unsigned int QuadIndexBuffer::mCapacity = 0;
+
+void QuadIndexBuffer::bind(void)
+{
+    if (mIbo == 0)
+    {
+        glGenBuffers(1, &mIbo);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIbo);
+}
+
+void QuadIndexBuffer::reserve(unsigned int quads)
+{
+    bind();
+
+    if (quads <= mCapacity)
+    {
+        return;
+    }
+
+    // Grow geometrically to avoid regenerating the buffer for every small
+    // increase in the number of quads.
+    unsigned int capacity = (mCapacity > 0) ? mCapacity : 1024;
+    while (capacity < quads)
+    {
+        capacity *= 2;
+    }
+
+    std::vector<GLuint> indices(capacity * INDICES_PER_QUAD);
+    for (unsigned int q = 0; q < capacity; q++)
+    {
+        GLuint base = q * VERTICES_PER_QUAD;
+        GLuint *i = &indices[q * INDICES_PER_QUAD];
+
+        i[0] = base;
+        i[1] = base + 1;
+        i[2] = base + 2;
+        i[3] = base;
+        i[4] = base + 2;
+        i[5] = base + 3;
+    }
+
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+        indices.data(), GL_STATIC_DRAW);
+    mCapacity = capacity;
+}
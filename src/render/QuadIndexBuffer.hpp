@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file QuadIndexBuffer.hpp
+/// @brief A shared index buffer for drawing quads.
+///
+/// This file contains the QuadIndexBuffer class. It owns a single OpenGL index
+/// buffer that turns every four vertices into the two triangles of a quad, so
+/// that any mesh made of quads can be drawn without its own index buffer.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_QUAD_INDEX_BUFFER_H_
+#define _CAMBRE_QUAD_INDEX_BUFFER_H_
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+/// @class QuadIndexBuffer
+/// @brief A shared index buffer for drawing quads.
+///
+/// The index buffer contains the indices 0, 1, 2, 0, 2, 3 for each quad, offset
+/// by four vertices per quad. The buffer only ever grows, and it keeps the same
+/// OpenGL name when it grows so that Vertex Array Objects that reference it
+/// remain valid.
+class QuadIndexBuffer
+{
+public:
+    /// @brief Binds the index buffer to the current Vertex Array Object.
+    ///
+    /// This function binds the shared buffer as the element array buffer,
+    /// creating it first if necessary.
+    static void bind(void);
+
+    /// @brief Ensures that the index buffer can draw a number of quads.
+    ///
+    /// This function grows the index buffer if it holds fewer than the
+    /// requested number of quads. The buffer is bound to the current Vertex
+    /// Array Object as a side effect.
+    static void reserve(unsigned int quads);
+
+    /// @brief The number of indices needed to draw one quad.
+    static const int INDICES_PER_QUAD = 6;
+
+    /// @brief The number of vertices in one quad.
+    static const int VERTICES_PER_QUAD = 4;
+
+private:
+    /// @brief The OpenGL Index Buffer Object.
+    static GLuint mIbo;
+
+    /// @brief The number of quads the index buffer can draw.
+    static unsigned int mCapacity;
+};
+
+#endif
@@ -1,14 +1,37 @@
 #version 410
 
-layout (location = 0) in vec4 Position;
+// The packed chunk vertex, as described by ChunkVertex.hpp. The first word
+// holds the x, y, and z positions with PositionBits bits each. The face
+// normal (3 bits) and the block type follow the positions in the first word,
+// or fill the second word when they do not fit. A single word vertex is read
+// with a second word of zero.
+layout (location = 0) in uvec2 Vertex;
 
+uniform uvec3 PositionBits;
 uniform mat4 Model;
 uniform mat4 ViewProjection;
 
 out vec4 Color;
+out float Shade;
+
+// The shading of each face normal, indexed by Chunk::ChunkDirectionEnum.
+const float NormalShade[6] = float[6](0.8, 0.8, 1.0, 0.5, 0.9, 0.9);
 
 void main()
 {
-    gl_Position = ViewProjection * Model * vec4(Position.xyz, 1.0);
-    Color = Position;
+    uvec3 mask = (uvec3(1u) << PositionBits) - uvec3(1u);
+    vec3 position = vec3(
+        Vertex.x & mask.x,
+        (Vertex.x >> PositionBits.x) & mask.y,
+        (Vertex.x >> (PositionBits.x + PositionBits.y)) & mask.z);
+
+    uint attributes =
+        (Vertex.x >> (PositionBits.x + PositionBits.y + PositionBits.z)) |
+        Vertex.y;
+    uint normal = attributes & 7u;
+    uint type = attributes >> 3u;
+
+    gl_Position = ViewProjection * Model * vec4(position, 1.0);
+    Color = vec4(position, float(type));
+    Shade = NormalShade[normal];
 }
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file BitOps.hpp
+/// @brief Portable bit manipulation helpers.
+///
+/// This file contains small wrappers around the compiler intrinsics used to
+/// count and locate set bits.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_BIT_OPS_H_
+#define _CAMBRE_BIT_OPS_H_
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/// @brief Counts the number of set bits in a value.
+inline int popCount(uint32_t value)
+{
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt(value));
+#else
+    return __builtin_popcount(value);
+#endif
+}
+
+/// @brief Counts the number of set bits in a 64-bit value.
+inline int popCount(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(value));
+#elif defined(_MSC_VER)
+    return popCount(static_cast<uint32_t>(value)) +
+        popCount(static_cast<uint32_t>(value >> 32));
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+/// @brief Finds the index of the least significant set bit of a value.
+///
+/// The value must not be zero.
+inline int countTrailingZeros(uint32_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+/// @brief Finds the index of the least significant set bit of a 64-bit value.
+///
+/// The value must not be zero.
+inline int countTrailingZeros(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#elif defined(_MSC_VER)
+    return (static_cast<uint32_t>(value) != 0)
+        ? countTrailingZeros(static_cast<uint32_t>(value))
+        : 32 + countTrailingZeros(static_cast<uint32_t>(value >> 32));
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+/// @brief Gets the number of bits needed to hold a value.
+///
+/// This is evaluated at compile time when the value is a constant.
+constexpr int bitWidth(uint32_t value)
+{
+    return (value == 0) ? 0 : 1 + bitWidth(value >> 1);
+}
+
+#endif
@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file CoordinateMap.hpp
+/// @brief A flat hash map keyed by integer coordinates.
+///
+/// This file contains the CoordinateMap class template. It maps glm::ivec3
+/// coordinates to values with open addressing, so that lookups touch a single
+/// contiguous array instead of following the nodes of a std::unordered_map.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_COORDINATE_MAP_H_
+#define _CAMBRE_COORDINATE_MAP_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Hash.hpp"
+
+/// @class CoordinateMap
+/// @brief A flat hash map keyed by integer coordinates.
+///
+/// The entries are stored in a single array whose size is a power of two, and
+/// collisions are resolved by linear probing. The array grows once it is three
+/// quarters full. Entries are removed by shifting the rest of their probe
+/// sequence back, so no tombstones are left behind and lookups never slow down
+/// as chunks are loaded and unloaded.
+///
+/// Inserting or erasing an entry invalidates pointers to the values and any
+/// iterators over the map.
+template <typename T>
+class CoordinateMap
+{
+public:
+    /// @brief The key and value of an entry.
+    typedef std::pair<glm::ivec3, T> Entry;
+
+    /// @brief The smallest number of slots allocated for a map.
+    static const unsigned int MIN_CAPACITY = 16;
+
+    /// @class Iterator
+    /// @brief Visits the entries of a map in storage order.
+    class Iterator
+    {
+    public:
+        Iterator(CoordinateMap *map, unsigned int slot)
+            : mMap(map), mSlot(slot)
+        {
+            skipEmpty();
+        }
+
+        Entry &operator*(void) const
+        {
+            return mMap->mEntries[mSlot];
+        }
+
+        Entry *operator->(void) const
+        {
+            return &mMap->mEntries[mSlot];
+        }
+
+        Iterator &operator++(void)
+        {
+            mSlot++;
+            skipEmpty();
+            return *this;
+        }
+
+        bool operator!=(const Iterator &other) const
+        {
+            return mSlot != other.mSlot;
+        }
+
+    private:
+        void skipEmpty(void)
+        {
+            while ((mSlot < mMap->mOccupied.size()) && !mMap->mOccupied[mSlot])
+            {
+                mSlot++;
+            }
+        }
+
+        CoordinateMap *mMap;
+        unsigned int mSlot;
+    };
+
+    CoordinateMap(void);
+
+    /// @brief Gets the value stored for a key.
+    ///
+    /// @returns The value, or null if the key is not in the map.
+    T *find(const glm::ivec3 &key);
+
+    /// @brief Adds an entry to the map.
+    ///
+    /// @returns True if the entry was added, or false if the key was already
+    /// in the map, in which case its value is left unchanged.
+    bool insert(const glm::ivec3 &key, const T &value);
+
+    /// @brief Removes an entry from the map.
+    ///
+    /// @returns True if the key was in the map.
+    bool erase(const glm::ivec3 &key);
+
+    /// @brief Removes every entry, keeping the allocated slots.
+    void clear(void);
+
+    /// @brief Allocates enough slots to hold a number of entries without
+    /// growing.
+    void reserve(unsigned int count);
+
+    /// @brief Gets the number of entries in the map.
+    unsigned int size(void) const;
+
+    /// @brief Gets the number of slots that have been allocated.
+    unsigned int capacity(void) const;
+
+    Iterator begin(void);
+    Iterator end(void);
+
+private:
+    /// @brief Gets the first slot probed for a key.
+    unsigned int homeSlot(const glm::ivec3 &key) const
+    {
+        return static_cast<unsigned int>(
+            hashCoordinates(key.x, key.y, key.z)) & mMask;
+    }
+
+    /// @brief Finds the slot holding a key.
+    ///
+    /// @returns The slot, or the number of slots if the key is not found.
+    unsigned int findSlot(const glm::ivec3 &key) const;
+
+    /// @brief Moves the entries into a new array of slots.
+    void rehash(unsigned int capacity);
+
+    /// @brief The slots of the map.
+    std::vector<Entry> mEntries;
+
+    /// @brief A flag for each slot indicating that it holds an entry.
+    std::vector<uint8_t> mOccupied;
+
+    /// @brief The number of entries in the map.
+    unsigned int mSize;
+
+    /// @brief The number of slots minus one, used to wrap slot indices.
+    unsigned int mMask;
+};
+
+template <typename T>
+CoordinateMap<T>::CoordinateMap(void)
+{
+    mSize = 0;
+    mMask = 0;
+    rehash(MIN_CAPACITY);
+}
+
+template <typename T>
+T *CoordinateMap<T>::find(const glm::ivec3 &key)
+{
+    unsigned int slot = findSlot(key);
+    if (slot == mOccupied.size())
+    {
+        return nullptr;
+    }
+
+    return &mEntries[slot].second;
+}
+
+template <typename T>
+bool CoordinateMap<T>::insert(const glm::ivec3 &key, const T &value)
+{
+    if ((mSize + 1) * 4 > mOccupied.size() * 3)
+    {
+        rehash(mOccupied.size() * 2);
+    }
+
+    unsigned int slot = homeSlot(key);
+    while (mOccupied[slot])
+    {
+        if (mEntries[slot].first == key)
+        {
+            return false;
+        }
+
+        slot = (slot + 1) & mMask;
+    }
+
+    mEntries[slot] = Entry(key, value);
+    mOccupied[slot] = 1;
+    mSize++;
+
+    return true;
+}
+
+template <typename T>
+bool CoordinateMap<T>::erase(const glm::ivec3 &key)
+{
+    unsigned int hole = findSlot(key);
+    if (hole == mOccupied.size())
+    {
+        return false;
+    }
+
+    mOccupied[hole] = 0;
+    mSize--;
+
+    // Shift the following entries of the probe sequence back into the hole,
+    // unless the hole lies before the slot where their probe starts.
+    unsigned int slot = (hole + 1) & mMask;
+    while (mOccupied[slot])
+    {
+        unsigned int home = homeSlot(mEntries[slot].first);
+        bool reachable = (hole <= slot)
+            ? ((home <= hole) || (home > slot))
+            : ((home <= hole) && (home > slot));
+
+        if (reachable)
+        {
+            mEntries[hole] = std::move(mEntries[slot]);
+            mOccupied[hole] = 1;
+            mOccupied[slot] = 0;
+            hole = slot;
+        }
+
+        slot = (slot + 1) & mMask;
+    }
+
+    return true;
+}
+
+template <typename T>
+void CoordinateMap<T>::clear(void)
+{
+    mOccupied.assign(mOccupied.size(), 0);
+    mSize = 0;
+}
+
+template <typename T>
+void CoordinateMap<T>::reserve(unsigned int count)
+{
+    unsigned int capacity = mOccupied.size();
+    while (count * 4 > capacity * 3)
+    {
+        capacity *= 2;
+    }
+
+    if (capacity != mOccupied.size())
+    {
+        rehash(capacity);
+    }
+}
+
+template <typename T>
+unsigned int CoordinateMap<T>::size(void) const
+{
+    return mSize;
+}
+
+template <typename T>
+unsigned int CoordinateMap<T>::capacity(void) const
+{
+    return mOccupied.size();
+}
+
+template <typename T>
+typename CoordinateMap<T>::Iterator CoordinateMap<T>::begin(void)
+{
+    return Iterator(this, 0);
+}
+
+template <typename T>
+typename CoordinateMap<T>::Iterator CoordinateMap<T>::end(void)
+{
+    return Iterator(this, mOccupied.size());
+}
+
+template <typename T>
+unsigned int CoordinateMap<T>::findSlot(const glm::ivec3 &key) const
+{
+    // The map is never full, so every probe sequence ends at an empty slot.
+    unsigned int slot = homeSlot(key);
+    while (mOccupied[slot])
+    {
+        if (mEntries[slot].first == key)
+        {
+            return slot;
+        }
+
+        slot = (slot + 1) & mMask;
+    }
+
+    return mOccupied.size();
+}
+
+template <typename T>
+void CoordinateMap<T>::rehash(unsigned int capacity)
+{
+    std::vector<Entry> entries(capacity);
+    std::vector<uint8_t> occupied(capacity, 0);
+    entries.swap(mEntries);
+    occupied.swap(mOccupied);
+
+    mMask = capacity - 1;
+    mSize = 0;
+
+    for (unsigned int i = 0; i < occupied.size(); i++)
+    {
+        if (occupied[i])
+        {
+            insert(entries[i].first, entries[i].second);
+        }
+    }
+}
+
+#endif
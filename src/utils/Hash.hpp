@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file Hash.hpp
+/// @brief Hashing helpers.
+///
+/// This file contains a hash function for arbitrary blocks of memory, used to
+/// identify data by its contents, and a hash function for integer coordinates.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_HASH_H_
+#define _CAMBRE_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Hashes a block of memory.
+///
+/// This function implements the 64-bit FNV-1a hash. Equal hashes do not
+/// guarantee equal contents, so callers must still compare the data.
+/// http://www.isthe.com/chongo/tech/comp/fnv/
+inline uint64_t hashBytes(const void *data, size_t size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/// @brief Hashes a set of integer coordinates.
+///
+/// Each coordinate is multiplied by a different odd constant, and the sum is
+/// mixed with the splitmix64 finalizer, so that neighboring coordinates are
+/// spread over every bit of the hash. This makes the low bits suitable for
+/// indexing a table whose size is a power of two.
+inline uint64_t hashCoordinates(int32_t x, int32_t y, int32_t z)
+{
+    uint64_t hash =
+        (static_cast<uint64_t>(static_cast<uint32_t>(x)) *
+            0x9E3779B97F4A7C15ULL) +
+        (static_cast<uint64_t>(static_cast<uint32_t>(y)) *
+            0xC2B2AE3D27D4EB4FULL) +
+        (static_cast<uint64_t>(static_cast<uint32_t>(z)) *
+            0x165667B19E3779F9ULL);
+
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+
+    return hash;
+}
+
+#endif
@@ -0,0 +1,323 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file JobSystem.cpp
+/// @brief A work-stealing pool of threads that run jobs.
+///
+/// This file contains the JobSystem class. It runs small units of work on a
+/// pool of worker threads, lets a job wait for other jobs to finish before it
+/// runs, and hands jobs that must run on the main thread back to it.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "JobSystem.hpp"
+
+/// @brief The state of a job.
+///
+/// The blockers are the dependencies that have not finished, plus one while
+/// the job is being submitted, so that it is not scheduled before all of its
+/// dependencies have been registered. The mutex guards the done flag and the
+/// jobs waiting for this one.
+struct JobSystem::JobStruct
+{
+    JobFunction work;
+    JobAffinityEnum affinity;
+    std::atomic<int> blockers;
+    std::mutex mutex;
+    bool done;
+    std::vector<JobHandle> continuations;
+};
+
+// The job system and worker index of the current thread, or null and 0 on
+// threads that are not workers.
+static thread_local JobSystem *tSystem = nullptr;
+static thread_local unsigned int tWorker = 0;
+
+JobSystem::JobSystem(void)
+{
+    // Leave one hardware thread for the main loop.
+    unsigned int threads = std::thread::hardware_concurrency();
+    start((threads > 1) ? threads - 1 : 1);
+}
+
+JobSystem::JobSystem(unsigned int workers)
+{
+    start((workers > 0) ? workers : 1);
+}
+
+JobSystem::~JobSystem(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+
+    for (std::unique_ptr<WorkerStruct> &worker : mWorkers)
+    {
+        worker->thread.join();
+    }
+}
+
+void JobSystem::start(unsigned int workers)
+{
+    mQueued = 0;
+    mNextWorker = 0;
+    mSleeping = 0;
+    mStopping = false;
+    mJobsRun = 0;
+    mJobsStolen = 0;
+    mMainJobsRun = 0;
+
+    // Every deque exists before any worker starts stealing from them.
+    for (unsigned int i = 0; i < workers; i++)
+    {
+        mWorkers.push_back(std::unique_ptr<WorkerStruct>(new WorkerStruct));
+    }
+
+    for (unsigned int i = 0; i < workers; i++)
+    {
+        mWorkers[i]->thread = std::thread(&JobSystem::work, this, i);
+    }
+}
+
+JobSystem::JobHandle JobSystem::submit(JobFunction work,
+    JobAffinityEnum affinity)
+{
+    return submit(std::move(work), std::vector<JobHandle>(), affinity);
+}
+
+JobSystem::JobHandle JobSystem::submit(JobFunction work,
+    const std::vector<JobHandle> &dependencies, JobAffinityEnum affinity)
+{
+    JobHandle job = std::make_shared<JobStruct>();
+    job->work = std::move(work);
+    job->affinity = affinity;
+    job->blockers = 1;
+    job->done = false;
+
+    for (const JobHandle &dependency : dependencies)
+    {
+        if (!dependency)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->done)
+        {
+            dependency->continuations.push_back(job);
+            job->blockers++;
+        }
+    }
+
+    // Release the hold taken while registering the dependencies. If they have
+    // all finished, the job is ready.
+    if (--job->blockers == 0)
+    {
+        schedule(job);
+    }
+
+    return job;
+}
+
+JobSystem::JobHandle JobSystem::then(const JobHandle &job, JobFunction work,
+    JobAffinityEnum affinity)
+{
+    return submit(std::move(work), std::vector<JobHandle>{job}, affinity);
+}
+
+bool JobSystem::runMainThreadJob(void)
+{
+    JobHandle job;
+
+    {
+        std::lock_guard<std::mutex> lock(mMainMutex);
+        if (mMainJobs.empty())
+        {
+            return false;
+        }
+
+        job = std::move(mMainJobs.front());
+        mMainJobs.pop_front();
+    }
+
+    execute(job);
+    mMainJobsRun++;
+
+    return true;
+}
+
+bool JobSystem::isDone(const JobHandle &job)
+{
+    std::lock_guard<std::mutex> lock(job->mutex);
+    return job->done;
+}
+
+void JobSystem::wait(const JobHandle &job)
+{
+    // Only workers have a deque of their own; other threads can only steal.
+    bool worker = (tSystem == this);
+    unsigned int index = worker ? tWorker : mWorkers.size();
+
+    while (!isDone(job))
+    {
+        JobHandle other;
+        if (take(index, other))
+        {
+            execute(other);
+        }
+        else if (worker || !runMainThreadJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+unsigned int JobSystem::getWorkerCount(void)
+{
+    return mWorkers.size();
+}
+
+unsigned int JobSystem::getQueuedJobs(void)
+{
+    return mQueued;
+}
+
+void JobSystem::printStatistics(void)
+{
+    std::cout << "Jobs: " << mJobsRun << " run on " << mWorkers.size()
+        << " workers (" << mJobsStolen << " stolen), " << mMainJobsRun
+        << " run on the main thread" << std::endl;
+}
+
+void JobSystem::work(unsigned int index)
+{
+    tSystem = this;
+    tWorker = index;
+
+    // Once the system is stopping, the queued jobs are left in the deques to
+    // be dropped.
+    while (!mStopping)
+    {
+        JobHandle job;
+        if (take(index, job))
+        {
+            execute(job);
+            continue;
+        }
+
+        // Sleep until a job is queued. The count of sleeping workers is raised
+        // before the queue is checked, and schedule raises the count of jobs
+        // before it checks for sleeping workers, so a job queued in between
+        // always wakes a worker.
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleeping++;
+        mWake.wait(lock, [this] {
+            return mStopping || (mQueued > 0);
+        });
+        mSleeping--;
+    }
+}
+
+void JobSystem::schedule(const JobHandle &job)
+{
+    if (job->affinity == MAIN_THREAD)
+    {
+        std::lock_guard<std::mutex> lock(mMainMutex);
+        mMainJobs.push_back(job);
+        return;
+    }
+
+    // Workers keep the jobs they submit. Jobs from other threads are spread
+    // over the workers.
+    unsigned int index = (tSystem == this)
+        ? tWorker : mNextWorker++ % mWorkers.size();
+
+    // The count changes under the same lock as the deque, so it never drops
+    // below the number of jobs that can be taken.
+    {
+        std::lock_guard<std::mutex> lock(mWorkers[index]->mutex);
+        mWorkers[index]->jobs.push_back(job);
+        mQueued++;
+    }
+
+    if (mSleeping > 0)
+    {
+        // Taking the lock ensures a worker that is about to sleep is already
+        // waiting when it is notified.
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+        }
+        mWake.notify_one();
+    }
+}
+
+bool JobSystem::take(unsigned int index, JobHandle &job)
+{
+    unsigned int count = mWorkers.size();
+
+    // Take the newest job of the worker's own deque.
+    if (index < count)
+    {
+        WorkerStruct &worker = *mWorkers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty())
+        {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            mQueued--;
+            return true;
+        }
+    }
+
+    // Steal the oldest job of another worker, starting with the next one so
+    // that the thieves spread out.
+    for (unsigned int i = 1; i <= count; i++)
+    {
+        unsigned int victim = (index + i) % count;
+        if (victim == index)
+        {
+            continue;
+        }
+
+        WorkerStruct &worker = *mWorkers[victim];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty())
+        {
+            job = std::move(worker.jobs.front());
+            worker.jobs.pop_front();
+            mQueued--;
+            mJobsStolen++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::execute(const JobHandle &job)
+{
+    job->work();
+
+    // Release anything captured by the work, since handles may outlive it.
+    job->work = nullptr;
+    if (job->affinity == ANY_THREAD)
+    {
+        mJobsRun++;
+    }
+
+    std::vector<JobHandle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->done = true;
+        continuations.swap(job->continuations);
+    }
+
+    for (const JobHandle &continuation : continuations)
+    {
+        if (--continuation->blockers == 0)
+        {
+            schedule(continuation);
+        }
+    }
+}
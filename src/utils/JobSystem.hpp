@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file JobSystem.hpp
+/// @brief A work-stealing pool of threads that run jobs.
+///
+/// This file contains the JobSystem class. It runs small units of work on a
+/// pool of worker threads, lets a job wait for other jobs to finish before it
+/// runs, and hands jobs that must run on the main thread back to it.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_JOB_SYSTEM_H_
+#define _CAMBRE_JOB_SYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @class JobSystem
+/// @brief A work-stealing pool of threads that run jobs.
+///
+/// Each worker has its own deque of jobs. A worker pushes the jobs it submits
+/// onto the back of its own deque and takes its next job from the back, so
+/// related work stays on the same thread while it is still in the cache. A
+/// worker whose deque is empty steals the oldest job from the front of
+/// another worker's deque. Jobs submitted from other threads are spread over
+/// the workers in turn.
+///
+/// A job may depend on other jobs; it is scheduled once all of them have
+/// finished. Jobs with MAIN_THREAD affinity are queued for the main thread
+/// instead, which runs them through runMainThreadJob, so a chain of jobs can
+/// end with a continuation that touches state owned by the main thread.
+class JobSystem
+{
+public:
+    /// @brief An enum representing the threads that a job may run on.
+    enum JobAffinityEnum
+    {
+        ANY_THREAD = 0,
+        MAIN_THREAD
+    };
+
+    /// @brief The work done by a job.
+    typedef std::function<void(void)> JobFunction;
+
+    /// @brief The state of a job, which is only used through handles.
+    struct JobStruct;
+
+    /// @brief A handle to a submitted job.
+    typedef std::shared_ptr<JobStruct> JobHandle;
+
+    /// @brief The default constructor.
+    ///
+    /// Starts one worker thread per hardware thread, leaving one for the main
+    /// thread.
+    JobSystem(void);
+
+    /// @brief Starts the number of worker threads.
+    JobSystem(unsigned int workers);
+
+    /// @brief The default destructor.
+    ///
+    /// Stops and joins the worker threads once they finish the jobs they are
+    /// running. Jobs that have not started are dropped, along with the jobs
+    /// that depend on them.
+    ~JobSystem(void);
+
+    /// @brief Submits a job.
+    JobHandle submit(JobFunction work, JobAffinityEnum affinity = ANY_THREAD);
+
+    /// @brief Submits a job that runs once its dependencies have finished.
+    ///
+    /// Null handles in the dependencies are ignored.
+    JobHandle submit(JobFunction work,
+        const std::vector<JobHandle> &dependencies,
+        JobAffinityEnum affinity = ANY_THREAD);
+
+    /// @brief Submits a continuation that runs once a job has finished.
+    JobHandle then(const JobHandle &job, JobFunction work,
+        JobAffinityEnum affinity = ANY_THREAD);
+
+    /// @brief Runs the oldest job queued for the main thread.
+    ///
+    /// This function must be called on the main thread.
+    ///
+    /// @returns False if no jobs are queued for the main thread.
+    bool runMainThreadJob(void);
+
+    /// @brief Determines if a job has finished.
+    bool isDone(const JobHandle &job);
+
+    /// @brief Waits for a job to finish.
+    ///
+    /// The calling thread runs other jobs while it waits. When called on the
+    /// main thread, this includes the jobs queued for the main thread.
+    void wait(const JobHandle &job);
+
+    /// @brief Gets the number of worker threads.
+    unsigned int getWorkerCount(void);
+
+    /// @brief Gets the number of jobs waiting to run on the workers.
+    unsigned int getQueuedJobs(void);
+
+    /// @brief Prints the number of jobs run, stolen and run on the main
+    /// thread.
+    void printStatistics(void);
+
+private:
+    /// @brief A struct containing the state of a worker thread.
+    ///
+    /// The deque is locked by the worker and by the threads stealing from it.
+    struct WorkerStruct
+    {
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+        std::thread thread;
+    };
+
+    /// @brief Starts the worker threads.
+    void start(unsigned int workers);
+
+    /// @brief Runs the jobs of a worker until the system stops.
+    void work(unsigned int index);
+
+    /// @brief Queues a job whose dependencies have finished.
+    void schedule(const JobHandle &job);
+
+    /// @brief Takes a job from a worker's deque, or steals one from another
+    /// worker.
+    ///
+    /// @returns False if every deque is empty.
+    bool take(unsigned int index, JobHandle &job);
+
+    /// @brief Runs a job and schedules the jobs that were waiting for it.
+    void execute(const JobHandle &job);
+
+    /// @brief The worker threads.
+    std::vector<std::unique_ptr<WorkerStruct>> mWorkers;
+
+    /// @brief The jobs queued for the main thread.
+    std::deque<JobHandle> mMainJobs;
+    std::mutex mMainMutex;
+
+    /// @brief The number of jobs in the workers' deques.
+    std::atomic<unsigned int> mQueued;
+
+    /// @brief The worker that the next job from another thread is given to.
+    std::atomic<unsigned int> mNextWorker;
+
+    /// @brief The number of workers waiting for jobs.
+    std::atomic<unsigned int> mSleeping;
+
+    /// @brief Wakes the workers waiting for jobs or to stop.
+    std::mutex mSleepMutex;
+    std::condition_variable mWake;
+
+    /// @brief A flag telling the workers to exit.
+    ///
+    /// It is set under mSleepMutex, and read without it before each job.
+    std::atomic<bool> mStopping;
+
+    /// @brief The number of jobs run on the workers, the number of those that
+    /// were stolen, and the number run on the main thread.
+    std::atomic<unsigned long> mJobsRun;
+    std::atomic<unsigned long> mJobsStolen;
+    std::atomic<unsigned long> mMainJobsRun;
+};
+
+#endif
@@ -0,0 +1,422 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file Noise.cpp
+/// @brief Gradient noise evaluated in batches.
+///
+/// This file contains the Noise class. It samples fractal gradient noise in two
+/// and three dimensions for arrays of points, evaluating several points at once
+/// with SIMD instructions when they are available.
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include <cmath>
+
+#include "Noise.hpp"
+
+// The kernels below are written once against these operations, which act on
+// every lane of a register. Floats holds the coordinates and values, Ints the
+// lattice coordinates and hashes, and Mask the result of a comparison.
+#if defined(__AVX2__)
+
+typedef __m256 Floats;
+typedef __m256i Ints;
+typedef __m256 Mask;
+static const int WIDTH = 8;
+
+static inline Floats load(const float *p) { return _mm256_loadu_ps(p); }
+static inline void store(float *p, Floats v) { _mm256_storeu_ps(p, v); }
+static inline Floats set(float v) { return _mm256_set1_ps(v); }
+static inline Floats add(Floats a, Floats b) { return _mm256_add_ps(a, b); }
+static inline Floats sub(Floats a, Floats b) { return _mm256_sub_ps(a, b); }
+static inline Floats mul(Floats a, Floats b) { return _mm256_mul_ps(a, b); }
+static inline Floats floorLanes(Floats v) { return _mm256_floor_ps(v); }
+static inline Ints toInts(Floats v) { return _mm256_cvttps_epi32(v); }
+
+static inline Ints set(uint32_t v)
+{
+    return _mm256_set1_epi32(static_cast<int32_t>(v));
+}
+
+static inline Ints add(Ints a, Ints b) { return _mm256_add_epi32(a, b); }
+static inline Ints mul(Ints a, Ints b) { return _mm256_mullo_epi32(a, b); }
+static inline Ints bitXor(Ints a, Ints b) { return _mm256_xor_si256(a, b); }
+static inline Ints bitAnd(Ints a, Ints b) { return _mm256_and_si256(a, b); }
+
+template<int N> static inline Ints shiftRight(Ints v)
+{
+    return _mm256_srli_epi32(v, N);
+}
+
+static inline Mask equal(Ints a, Ints b)
+{
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b));
+}
+
+static inline Mask less(Ints a, Ints b)
+{
+    return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a));
+}
+
+static inline Mask either(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+
+static inline Floats select(Mask m, Floats a, Floats b)
+{
+    return _mm256_blendv_ps(b, a, m);
+}
+
+static inline Floats negateIf(Mask m, Floats v)
+{
+    return _mm256_xor_ps(v, _mm256_and_ps(m, _mm256_set1_ps(-0.0f)));
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+typedef __m128 Floats;
+typedef __m128i Ints;
+typedef __m128 Mask;
+static const int WIDTH = 4;
+
+static inline Floats load(const float *p) { return _mm_loadu_ps(p); }
+static inline void store(float *p, Floats v) { _mm_storeu_ps(p, v); }
+static inline Floats set(float v) { return _mm_set1_ps(v); }
+static inline Floats add(Floats a, Floats b) { return _mm_add_ps(a, b); }
+static inline Floats sub(Floats a, Floats b) { return _mm_sub_ps(a, b); }
+static inline Floats mul(Floats a, Floats b) { return _mm_mul_ps(a, b); }
+static inline Ints toInts(Floats v) { return _mm_cvttps_epi32(v); }
+
+static inline Floats floorLanes(Floats v)
+{
+    // SSE2 only truncates, which rounds negative values up.
+    Floats t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, v), _mm_set1_ps(1.0f)));
+}
+
+static inline Ints set(uint32_t v)
+{
+    return _mm_set1_epi32(static_cast<int32_t>(v));
+}
+
+static inline Ints add(Ints a, Ints b) { return _mm_add_epi32(a, b); }
+static inline Ints bitXor(Ints a, Ints b) { return _mm_xor_si128(a, b); }
+static inline Ints bitAnd(Ints a, Ints b) { return _mm_and_si128(a, b); }
+
+static inline Ints mul(Ints a, Ints b)
+{
+    // SSE2 only multiplies the even lanes, so the odd lanes are shifted down,
+    // multiplied separately and interleaved with the even products.
+    Ints even = _mm_mul_epu32(a, b);
+    Ints odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+template<int N> static inline Ints shiftRight(Ints v)
+{
+    return _mm_srli_epi32(v, N);
+}
+
+static inline Mask equal(Ints a, Ints b)
+{
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b));
+}
+
+static inline Mask less(Ints a, Ints b)
+{
+    return _mm_castsi128_ps(_mm_cmplt_epi32(a, b));
+}
+
+static inline Mask either(Mask a, Mask b) { return _mm_or_ps(a, b); }
+
+static inline Floats select(Mask m, Floats a, Floats b)
+{
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+
+static inline Floats negateIf(Mask m, Floats v)
+{
+    return _mm_xor_ps(v, _mm_and_ps(m, _mm_set1_ps(-0.0f)));
+}
+
+#else
+
+typedef float Floats;
+typedef uint32_t Ints;
+typedef bool Mask;
+static const int WIDTH = 1;
+
+static inline Floats load(const float *p) { return *p; }
+static inline void store(float *p, Floats v) { *p = v; }
+static inline Floats set(float v) { return v; }
+static inline Floats add(Floats a, Floats b) { return a + b; }
+static inline Floats sub(Floats a, Floats b) { return a - b; }
+static inline Floats mul(Floats a, Floats b) { return a * b; }
+static inline Floats floorLanes(Floats v) { return std::floor(v); }
+
+static inline Ints toInts(Floats v)
+{
+    return static_cast<uint32_t>(static_cast<int32_t>(v));
+}
+
+static inline Ints set(uint32_t v) { return v; }
+static inline Ints add(Ints a, Ints b) { return a + b; }
+static inline Ints mul(Ints a, Ints b) { return a * b; }
+static inline Ints bitXor(Ints a, Ints b) { return a ^ b; }
+static inline Ints bitAnd(Ints a, Ints b) { return a & b; }
+
+template<int N> static inline Ints shiftRight(Ints v)
+{
+    return v >> N;
+}
+
+static inline Mask equal(Ints a, Ints b) { return a == b; }
+static inline Mask less(Ints a, Ints b) { return a < b; }
+static inline Mask either(Mask a, Mask b) { return a || b; }
+static inline Floats select(Mask m, Floats a, Floats b) { return m ? a : b; }
+static inline Floats negateIf(Mask m, Floats v) { return m ? -v : v; }
+
+#endif
+
+const int Noise::LANES = WIDTH;
+
+// The odd constants that the lattice coordinates are multiplied by before they
+// are mixed, one per axis.
+static const uint32_t HASH_X = 0x8DA6B343;
+static const uint32_t HASH_Y = 0xD8163841;
+static const uint32_t HASH_Z = 0xCB1AB31F;
+
+// The amount added to the seed for each octave, so that the octaves are not
+// correlated.
+static const uint32_t OCTAVE_SEED_STEP = 0x9E3779B9;
+
+// Mixes the bits of a hash so that the low bits depend on every input bit.
+static inline Ints mixHash(Ints h)
+{
+    h = bitXor(h, shiftRight<16>(h));
+    h = mul(h, set(static_cast<uint32_t>(0x7FEB352D)));
+    h = bitXor(h, shiftRight<15>(h));
+    h = mul(h, set(static_cast<uint32_t>(0x846CA68B)));
+    return bitXor(h, shiftRight<16>(h));
+}
+
+static inline Ints hash2D(Ints x, Ints z, Ints seed)
+{
+    return mixHash(bitXor(bitXor(mul(x, set(HASH_X)), mul(z, set(HASH_Z))),
+        seed));
+}
+
+static inline Ints hash3D(Ints x, Ints y, Ints z, Ints seed)
+{
+    return mixHash(bitXor(bitXor(mul(x, set(HASH_X)), mul(y, set(HASH_Y))),
+        bitXor(mul(z, set(HASH_Z)), seed)));
+}
+
+// Takes the dot product of the offset with one of 8 gradients.
+static inline Floats gradient2D(Ints hash, Floats x, Floats z)
+{
+    Ints h = bitAnd(hash, set(static_cast<uint32_t>(7)));
+    Mask low = less(h, set(static_cast<uint32_t>(4)));
+    Floats u = select(low, x, z);
+    Floats v = select(low, z, x);
+    Ints one = set(static_cast<uint32_t>(1));
+    Ints two = set(static_cast<uint32_t>(2));
+
+    return add(negateIf(equal(bitAnd(h, one), one), u),
+        negateIf(equal(bitAnd(h, two), two), add(v, v)));
+}
+
+// Takes the dot product of the offset with one of the 12 gradients of the
+// improved noise, the 16 hashes mapping onto them as in Perlin's reference.
+static inline Floats gradient3D(Ints hash, Floats x, Floats y, Floats z)
+{
+    Ints h = bitAnd(hash, set(static_cast<uint32_t>(15)));
+    Floats u = select(less(h, set(static_cast<uint32_t>(8))), x, y);
+    Mask useX = either(equal(h, set(static_cast<uint32_t>(12))),
+        equal(h, set(static_cast<uint32_t>(14))));
+    Floats v = select(less(h, set(static_cast<uint32_t>(4))), y,
+        select(useX, x, z));
+    Ints one = set(static_cast<uint32_t>(1));
+    Ints two = set(static_cast<uint32_t>(2));
+
+    return add(negateIf(equal(bitAnd(h, one), one), u),
+        negateIf(equal(bitAnd(h, two), two), v));
+}
+
+static inline Floats fade(Floats t)
+{
+    Floats inner = add(mul(t, sub(mul(t, set(6.0f)), set(15.0f))),
+        set(10.0f));
+    return mul(mul(mul(t, t), t), inner);
+}
+
+static inline Floats lerp(Floats a, Floats b, Floats t)
+{
+    return add(a, mul(t, sub(b, a)));
+}
+
+static Floats noise2D(Floats x, Floats z, Ints seed)
+{
+    Floats fx = floorLanes(x);
+    Floats fz = floorLanes(z);
+    Ints x0 = toInts(fx);
+    Ints z0 = toInts(fz);
+    Ints x1 = add(x0, set(static_cast<uint32_t>(1)));
+    Ints z1 = add(z0, set(static_cast<uint32_t>(1)));
+    Floats tx = sub(x, fx);
+    Floats tz = sub(z, fz);
+    Floats one = set(1.0f);
+
+    Floats n00 = gradient2D(hash2D(x0, z0, seed), tx, tz);
+    Floats n10 = gradient2D(hash2D(x1, z0, seed), sub(tx, one), tz);
+    Floats n01 = gradient2D(hash2D(x0, z1, seed), tx, sub(tz, one));
+    Floats n11 = gradient2D(hash2D(x1, z1, seed), sub(tx, one),
+        sub(tz, one));
+
+    Floats u = fade(tx);
+    return lerp(lerp(n00, n10, u), lerp(n01, n11, u), fade(tz));
+}
+
+static Floats noise3D(Floats x, Floats y, Floats z, Ints seed)
+{
+    Floats fx = floorLanes(x);
+    Floats fy = floorLanes(y);
+    Floats fz = floorLanes(z);
+    Ints x0 = toInts(fx);
+    Ints y0 = toInts(fy);
+    Ints z0 = toInts(fz);
+    Ints x1 = add(x0, set(static_cast<uint32_t>(1)));
+    Ints y1 = add(y0, set(static_cast<uint32_t>(1)));
+    Ints z1 = add(z0, set(static_cast<uint32_t>(1)));
+    Floats tx = sub(x, fx);
+    Floats ty = sub(y, fy);
+    Floats tz = sub(z, fz);
+    Floats one = set(1.0f);
+    Floats sx = sub(tx, one);
+    Floats sy = sub(ty, one);
+    Floats sz = sub(tz, one);
+
+    Floats n000 = gradient3D(hash3D(x0, y0, z0, seed), tx, ty, tz);
+    Floats n100 = gradient3D(hash3D(x1, y0, z0, seed), sx, ty, tz);
+    Floats n010 = gradient3D(hash3D(x0, y1, z0, seed), tx, sy, tz);
+    Floats n110 = gradient3D(hash3D(x1, y1, z0, seed), sx, sy, tz);
+    Floats n001 = gradient3D(hash3D(x0, y0, z1, seed), tx, ty, sz);
+    Floats n101 = gradient3D(hash3D(x1, y0, z1, seed), sx, ty, sz);
+    Floats n011 = gradient3D(hash3D(x0, y1, z1, seed), tx, sy, sz);
+    Floats n111 = gradient3D(hash3D(x1, y1, z1, seed), sx, sy, sz);
+
+    Floats u = fade(tx);
+    Floats v = fade(ty);
+    return lerp(
+        lerp(lerp(n000, n100, u), lerp(n010, n110, u), v),
+        lerp(lerp(n001, n101, u), lerp(n011, n111, u), v),
+        fade(tz));
+}
+
+static Floats fractal2D(Floats x, Floats z, uint32_t seed, int octaves)
+{
+    Floats sum = set(0.0f);
+    float amplitude = 1.0f;
+    float total = 0.0f;
+
+    for (int i = 0; i < octaves; i++)
+    {
+        sum = add(sum, mul(set(amplitude), noise2D(x, z, set(seed))));
+        total += amplitude;
+        amplitude *= 0.5f;
+        x = add(x, x);
+        z = add(z, z);
+        seed += OCTAVE_SEED_STEP;
+    }
+
+    return mul(sum, set(1.0f / total));
+}
+
+static Floats fractal3D(Floats x, Floats y, Floats z, uint32_t seed,
+    int octaves)
+{
+    Floats sum = set(0.0f);
+    float amplitude = 1.0f;
+    float total = 0.0f;
+
+    for (int i = 0; i < octaves; i++)
+    {
+        sum = add(sum, mul(set(amplitude), noise3D(x, y, z, set(seed))));
+        total += amplitude;
+        amplitude *= 0.5f;
+        x = add(x, x);
+        y = add(y, y);
+        z = add(z, z);
+        seed += OCTAVE_SEED_STEP;
+    }
+
+    return mul(sum, set(1.0f / total));
+}
+
+Noise::Noise(uint32_t seed)
+{
+    mSeed = seed;
+}
+
+void Noise::sample2D(const float *x, const float *z, float *out, int count,
+    int octaves) const
+{
+    int i = 0;
+    for (; i + WIDTH <= count; i += WIDTH)
+    {
+        store(out + i, fractal2D(load(x + i), load(z + i), mSeed, octaves));
+    }
+
+    // The last points are copied into full registers.
+    if (i < count)
+    {
+        float px[WIDTH] = {0};
+        float pz[WIDTH] = {0};
+        float po[WIDTH];
+        for (int j = i; j < count; j++)
+        {
+            px[j - i] = x[j];
+            pz[j - i] = z[j];
+        }
+
+        store(po, fractal2D(load(px), load(pz), mSeed, octaves));
+        for (int j = i; j < count; j++)
+        {
+            out[j] = po[j - i];
+        }
+    }
+}
+
+void Noise::sample3D(const float *x, const float *y, const float *z,
+    float *out, int count, int octaves) const
+{
+    int i = 0;
+    for (; i + WIDTH <= count; i += WIDTH)
+    {
+        store(out + i, fractal3D(load(x + i), load(y + i), load(z + i), mSeed,
+            octaves));
+    }
+
+    // The last points are copied into full registers.
+    if (i < count)
+    {
+        float px[WIDTH] = {0};
+        float py[WIDTH] = {0};
+        float pz[WIDTH] = {0};
+        float po[WIDTH];
+        for (int j = i; j < count; j++)
+        {
+            px[j - i] = x[j];
+            py[j - i] = y[j];
+            pz[j - i] = z[j];
+        }
+
+        store(po, fractal3D(load(px), load(py), load(pz), mSeed, octaves));
+        for (int j = i; j < count; j++)
+        {
+            out[j] = po[j - i];
+        }
+    }
+}
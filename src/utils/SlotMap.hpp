@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file SlotMap.hpp
+/// @brief A pool of objects addressed by generation-checked handles.
+///
+/// This file contains the SlotMap class template. It recycles objects instead
+/// of allocating and freeing them, and hands out handles that detect when the
+/// object they referred to has been released.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_SLOT_MAP_H_
+#define _CAMBRE_SLOT_MAP_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// @brief A struct containing a handle to an object in a SlotMap.
+///
+/// A handle with a generation of 0 is null and never refers to an object.
+struct SlotHandleStruct
+{
+    uint32_t index;
+    uint32_t generation;
+};
+
+inline bool operator==(const SlotHandleStruct &a, const SlotHandleStruct &b)
+{
+    return (a.index == b.index) && (a.generation == b.generation);
+}
+
+inline bool operator!=(const SlotHandleStruct &a, const SlotHandleStruct &b)
+{
+    return !(a == b);
+}
+
+/// @class SlotMap
+/// @brief A pool of objects addressed by generation-checked handles.
+///
+/// Objects are allocated in pages of PAGE_SIZE, so their addresses never
+/// change, and released slots are reused before new pages are allocated.
+/// Objects are not destroyed when they are erased; the owner is expected to
+/// reinitialize an object when its slot is reused. Each slot has a generation
+/// that is incremented when the slot is erased, so a handle to an erased
+/// object no longer resolves, even after the slot has been reused.
+template <typename T>
+class SlotMap
+{
+public:
+    /// @brief The number of objects allocated at once.
+    static const unsigned int PAGE_SIZE = 256;
+
+    /// @brief Takes a slot from the pool.
+    ///
+    /// @returns The handle to the slot. The object in the slot is either
+    /// default constructed or left as it was when its slot was erased.
+    SlotHandleStruct insert(void);
+
+    /// @brief Returns a slot to the pool.
+    ///
+    /// The handle, and every copy of it, becomes stale. Stale and null handles
+    /// are ignored.
+    void erase(SlotHandleStruct handle);
+
+    /// @brief Gets the object that a handle refers to.
+    ///
+    /// @returns The object, or null if the handle is null or stale.
+    T *get(SlotHandleStruct handle);
+
+    /// @brief Gets the number of slots in use.
+    unsigned int size(void) const;
+
+    /// @brief Gets the number of slots that have been allocated.
+    unsigned int capacity(void) const;
+
+private:
+    /// @brief The pages of objects.
+    std::vector<std::unique_ptr<T[]>> mPages;
+
+    /// @brief The current generation of each slot.
+    ///
+    /// The generation is even while a slot is free and odd while it is in
+    /// use, so a slot's generation can only be matched by a live handle.
+    std::vector<uint32_t> mGenerations;
+
+    /// @brief The indices of the free slots.
+    std::vector<uint32_t> mFreeSlots;
+};
+
+template <typename T>
+SlotHandleStruct SlotMap<T>::insert(void)
+{
+    if (mFreeSlots.empty())
+    {
+        // Allocate a new page, and add its slots to the free list in reverse
+        // so that they are used in order.
+        uint32_t first = mGenerations.size();
+        mPages.push_back(std::unique_ptr<T[]>(new T[PAGE_SIZE]));
+        mGenerations.resize(first + PAGE_SIZE, 0);
+
+        for (uint32_t i = PAGE_SIZE; i > 0; i--)
+        {
+            mFreeSlots.push_back(first + i - 1);
+        }
+    }
+
+    uint32_t index = mFreeSlots.back();
+    mFreeSlots.pop_back();
+
+    // Mark the slot as in use.
+    mGenerations[index]++;
+
+    return SlotHandleStruct{index, mGenerations[index]};
+}
+
+template <typename T>
+void SlotMap<T>::erase(SlotHandleStruct handle)
+{
+    if (get(handle) == nullptr)
+    {
+        return;
+    }
+
+    // Mark the slot as free, which makes every handle to it stale.
+    mGenerations[handle.index]++;
+    mFreeSlots.push_back(handle.index);
+}
+
+template <typename T>
+T *SlotMap<T>::get(SlotHandleStruct handle)
+{
+    if ((handle.generation == 0) || (handle.index >= mGenerations.size()) ||
+        (mGenerations[handle.index] != handle.generation))
+    {
+        return nullptr;
+    }
+
+    return &mPages[handle.index / PAGE_SIZE][handle.index % PAGE_SIZE];
+}
+
+template <typename T>
+unsigned int SlotMap<T>::size(void) const
+{
+    return mGenerations.size() - mFreeSlots.size();
+}
+
+template <typename T>
+unsigned int SlotMap<T>::capacity(void) const
+{
+    return mGenerations.size();
+}
+
+#endif
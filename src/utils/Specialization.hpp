@@ -13,21 +13,19 @@
 
 #include <glm/glm.hpp>
 
+#include "Hash.hpp"
+
 namespace std
 {
-    // This template
+    // This template allows glm::ivec3 to be used as the key of unordered
+    // containers.
     template<> struct hash<glm::ivec3>
     {
         typedef glm::ivec3 argument_type;
         typedef std::size_t result_type;
         result_type operator()(argument_type const& a) const noexcept
         {
-            // Use the C++ builtin hashing algorithm on each method and combine
-            // the hashes.
-            result_type h = std::hash<int>()(a.x);
-            h ^= std::hash<int>()(a.y) + 0x9e3779b9 + (h << 6) + (h >> 2);
-            h ^= std::hash<int>()(a.z) + 0x9e3779b9 + (h << 6) + (h >> 2);
-            return h;
+            return static_cast<result_type>(hashCoordinates(a.x, a.y, a.z));
         }
     };
 }
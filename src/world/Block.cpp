@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file Block.cpp
+/// @brief The registry of the types of blocks in the world.
+///
+/// This file contains the Block class. It assigns an id to each type of block
+/// and stores the properties of every type in flat tables, so that hot loops
+/// such as the mesher can look up a property with a single array access.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "Block.hpp"
+#include "ChunkVertex.hpp"
+
+// The default blocks are part of the static initialization of the tables, so
+// they are registered before any code runs. The entries are in the order of
+// Block::DefaultBlockEnum.
+uint8_t Block::mOpaque[TABLE_SIZE] = {0, 1, 0, 0};
+uint8_t Block::mTransparent[TABLE_SIZE] = {0, 0, 1, 1};
+uint8_t Block::mLightEmission[TABLE_SIZE] = {0, 0, 0, 0};
+uint8_t Block::mSolid[TABLE_SIZE] = {0, 1, 1, 0};
+uint8_t Block::mShape[TABLE_SIZE] = {SHAPE_NONE, SHAPE_CUBE, SHAPE_CUBE,
+    SHAPE_CUBE};
+
+std::vector<std::string> Block::mNames = {"air", "stone", "glass", "water"};
+
+BlockId Block::registerBlock(const BlockPropertiesStruct &properties)
+{
+    BlockId id;
+    if (find(properties.name, id))
+    {
+        std::cerr << "Block::registerBlock Block " << properties.name
+            << " is already registered" << std::endl;
+        return id;
+    }
+
+    // The type of a block must fit in a packed vertex.
+    if (mNames.size() >= (1u << ChunkVertex::TYPE_BITS))
+    {
+        std::cerr << "Block::registerBlock Too many blocks to register "
+            << properties.name << std::endl;
+        return AIR;
+    }
+
+    id = mNames.size();
+    mNames.push_back(properties.name);
+
+    mOpaque[id] = properties.opaque ? 1 : 0;
+    mTransparent[id] = properties.transparent ? 1 : 0;
+    mLightEmission[id] = properties.lightEmission;
+    mSolid[id] = properties.solid ? 1 : 0;
+    mShape[id] = properties.shape;
+
+    return id;
+}
+
+bool Block::find(const std::string &name, BlockId &id)
+{
+    for (unsigned int i = 0; i < mNames.size(); i++)
+    {
+        if (mNames[i] == name)
+        {
+            id = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Block::BlockPropertiesStruct Block::getProperties(BlockId id)
+{
+    BlockPropertiesStruct properties;
+    properties.name = (id < mNames.size()) ? mNames[id] : "";
+    properties.opaque = isOpaque(id);
+    properties.transparent = isTransparent(id);
+    properties.lightEmission = getLightEmission(id);
+    properties.solid = isSolid(id);
+    properties.shape = getShape(id);
+
+    return properties;
+}
+
+unsigned int Block::getBlockCount(void)
+{
+    return mNames.size();
+}
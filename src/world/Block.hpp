@@ -1,19 +1,139 @@
 ////////////////////////////////////////////////////////////////////////////////
 /// @file Block.hpp
-/// @brief The class to represent a single block in the world.
+/// @brief The registry of the types of blocks in the world.
 ///
-/// This file contains the Block Class, the basic block of the world.
+/// This file contains the Block class. It assigns an id to each type of block
+/// and stores the properties of every type in flat tables, so that hot loops
+/// such as the mesher can look up a property with a single array access.
 ////////////////////////////////////////////////////////////////////////////////
 
 #ifndef _CAMBRE_BLOCK_H_
 #define _CAMBRE_BLOCK_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief The type of a block.
+///
+/// A BlockId of 0 is an empty block (air).
+typedef uint16_t BlockId;
+
+/// @class Block
+/// @brief The registry of the types of blocks in the world.
+///
+/// Each property is kept in its own table indexed by BlockId (a structure of
+/// arrays). The tables cover every possible BlockId, so any id can be looked
+/// up without a bounds check; unregistered ids behave like air.
+///
+/// The default blocks are always registered. Other blocks must be registered
+/// during initialization, before any chunk is meshed, since the tables are
+/// read by the mesh worker threads without synchronization.
 class Block
 {
 public:
+    /// @brief An enum representing the geometry used to mesh a block.
+    ///
+    /// Only cubes are meshed at the moment; other shapes are reserved.
+    enum BlockShapeEnum
+    {
+        SHAPE_NONE = 0,
+        SHAPE_CUBE,
+        SHAPE_CROSS,
+        MAX_BLOCK_SHAPE
+    };
+
+    /// @brief An enum representing the blocks that are always registered.
+    enum DefaultBlockEnum
+    {
+        AIR = 0,
+        STONE,
+        GLASS,
+        WATER,
+        MAX_DEFAULT_BLOCK
+    };
+
+    /// @brief A struct containing the properties of a type of block.
+    ///
+    /// An opaque block hides the faces of the blocks behind it. A transparent
+    /// block can be seen through, and hides the faces it shares with blocks of
+    /// the same type, such as the inside of a body of water. A solid block
+    /// stops movement. The light emission ranges from 0 to 15.
+    struct BlockPropertiesStruct
+    {
+        std::string name;
+        bool opaque;
+        bool transparent;
+        uint8_t lightEmission;
+        bool solid;
+        BlockShapeEnum shape;
+    };
+
+    /// @brief The number of entries in each property table.
+    static const int TABLE_SIZE = 1 << (8 * sizeof(BlockId));
+
+    /// @brief Registers a type of block.
+    ///
+    /// @returns The id assigned to the block. If a block with the same name
+    /// has already been registered, its id is returned instead.
+    static BlockId registerBlock(const BlockPropertiesStruct &properties);
+
+    /// @brief Finds the id of a type of block by name.
+    ///
+    /// @returns True if the block was found.
+    static bool find(const std::string &name, BlockId &id);
+
+    /// @brief Gets all of the properties of a type of block.
+    static BlockPropertiesStruct getProperties(BlockId id);
+
+    /// @brief Gets the number of registered types of blocks.
+    static unsigned int getBlockCount(void);
+
+    static bool isOpaque(BlockId id)
+    {
+        return mOpaque[id] != 0;
+    }
+
+    static bool isTransparent(BlockId id)
+    {
+        return mTransparent[id] != 0;
+    }
+
+    static uint8_t getLightEmission(BlockId id)
+    {
+        return mLightEmission[id];
+    }
+
+    static bool isSolid(BlockId id)
+    {
+        return mSolid[id] != 0;
+    }
+
+    static BlockShapeEnum getShape(BlockId id)
+    {
+        return static_cast<BlockShapeEnum>(mShape[id]);
+    }
+
+    /// @brief Determines if a face of a block is visible.
+    ///
+    /// A face of a cube is visible unless the neighboring block across it is
+    /// opaque, or both blocks are the same transparent type.
+    static bool isFaceVisible(BlockId type, BlockId neighbor)
+    {
+        return (mShape[type] == SHAPE_CUBE) && (mOpaque[neighbor] == 0) &&
+            !((neighbor == type) && (mTransparent[type] != 0));
+    }
 
 private:
+    /// @brief The property tables, indexed by BlockId.
+    static uint8_t mOpaque[TABLE_SIZE];
+    static uint8_t mTransparent[TABLE_SIZE];
+    static uint8_t mLightEmission[TABLE_SIZE];
+    static uint8_t mSolid[TABLE_SIZE];
+    static uint8_t mShape[TABLE_SIZE];
 
+    /// @brief The names of the registered blocks, indexed by BlockId.
+    static std::vector<std::string> mNames;
 };
 
 #endif
@@ -0,0 +1,235 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file BlockStore.cpp
+/// @brief An immutable array of blocks shared between chunks.
+///
+/// This file contains the BlockStore class. Chunks with identical contents
+/// share a single BlockStore, which collapses the memory used by repetitive
+/// terrain and by the empty chunks that make up most of the world.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "BlockStore.hpp"
+
+// The number of blocks decoded at once when walking a store in layout order.
+// A span is a whole number of rows, and covers several bricks, so it stays in
+// the cache while its rows are copied out.
+static const int SPAN_BLOCKS = BlockLayout::ROW_LENGTH *
+    ((BlockLayout::ROW_LENGTH < 256) ? (256 / BlockLayout::ROW_LENGTH) : 1);
+
+// Decodes a storage one span at a time in layout order, and passes each row of
+// blocks that are consecutive along z to the visitor, along with the
+// coordinates of the row's first block.
+template <typename RowVisitor>
+static void forEachRow(const PaletteStorage &storage, RowVisitor visit)
+{
+    BlockId span[SPAN_BLOCKS];
+    for (int base = 0; base < BlockStore::BLOCK_COUNT; base += SPAN_BLOCKS)
+    {
+        int count = std::min(SPAN_BLOCKS, BlockStore::BLOCK_COUNT - base);
+        storage.unpack(base, count, span);
+
+        for (int i = 0; i < count; i += BlockLayout::ROW_LENGTH)
+        {
+            int x, y, z;
+            BlockLayout::coords(base + i, x, y, z);
+            visit(x, y, z, &span[i]);
+        }
+    }
+}
+
+std::unordered_multimap<uint64_t, BlockStore::StoreEntryStruct>
+    BlockStore::mStores;
+std::unordered_map<BlockId, BlockStore::StoreEntryStruct>
+    BlockStore::mUniformStores;
+size_t BlockStore::mTotalMemoryUsage = 0;
+
+BlockStore::BlockStore(PaletteStorage &&blocks, uint64_t hash)
+    : mBlocks(std::move(blocks))
+{
+    mUniformBlock = 0;
+    mUniform = false;
+    mHash = hash;
+}
+
+BlockStore::BlockStore(BlockId type)
+{
+    mUniformBlock = type;
+    mUniform = true;
+    mHash = 0;
+}
+
+std::shared_ptr<const BlockStore> BlockStore::intern(const BlockId *blocks)
+{
+    // Uniform blocks only store their type.
+    int i = 1;
+    while ((i < BLOCK_COUNT) && (blocks[i] == blocks[0]))
+    {
+        i++;
+    }
+
+    if (i == BLOCK_COUNT)
+    {
+        return internUniform(blocks[0]);
+    }
+
+    // Palette storages built from the same blocks are identical, so the
+    // packed form can be hashed and compared directly. Equal hashes are only
+    // a hint, so the storages themselves are compared.
+    PaletteStorage storage;
+    if (BlockLayout::IS_LINEAR)
+    {
+        storage.assign(blocks, BLOCK_COUNT);
+    }
+    else
+    {
+        // Each row in layout order is consecutive along z in the blocks too,
+        // so the rows are read in place.
+        storage.assignRows(BLOCK_COUNT, BlockLayout::ROW_LENGTH,
+            [blocks](unsigned int start) {
+                int x, y, z;
+                BlockLayout::coords(start, x, y, z);
+                return &blocks[BlockArrayLayout::index(x, y, z)];
+            });
+    }
+    uint64_t hash = storage.hash();
+
+    auto range = mStores.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.store->mBlocks == storage)
+        {
+            return it->second.reference.lock();
+        }
+    }
+
+    std::shared_ptr<const BlockStore> store(
+        new BlockStore(std::move(storage), hash), &BlockStore::release);
+    mStores.insert({hash, StoreEntryStruct{store.get(), store}});
+    mTotalMemoryUsage += store->getMemoryUsage();
+
+    return store;
+}
+
+std::shared_ptr<const BlockStore> BlockStore::internUniform(BlockId type)
+{
+    auto it = mUniformStores.find(type);
+    if (it != mUniformStores.end())
+    {
+        return it->second.reference.lock();
+    }
+
+    std::shared_ptr<const BlockStore> store(new BlockStore(type),
+        &BlockStore::release);
+    mUniformStores.insert({type, StoreEntryStruct{store.get(), store}});
+    mTotalMemoryUsage += store->getMemoryUsage();
+
+    return store;
+}
+
+void BlockStore::copyToVolume(BlockId *volume) const
+{
+    if (mUniform)
+    {
+        for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++)
+        {
+            for (int y = 0; y < Chunk::CHUNK_SIZE_Y; y++)
+            {
+                BlockId *row = &volume[Chunk::volumeIndex(x, y, 0)];
+                for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++)
+                {
+                    row[z] = mUniformBlock;
+                }
+            }
+        }
+
+        return;
+    }
+
+    // Rows of a linear layout are contiguous in both the storage and the
+    // volume.
+    if (BlockLayout::IS_LINEAR)
+    {
+        for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++)
+        {
+            for (int y = 0; y < Chunk::CHUNK_SIZE_Y; y++)
+            {
+                mBlocks.unpack(BlockLayout::index(x, y, 0),
+                    Chunk::CHUNK_SIZE_Z, &volume[Chunk::volumeIndex(x, y, 0)]);
+            }
+        }
+
+        return;
+    }
+
+    // Otherwise copy the rows of the layout straight into the volume.
+    forEachRow(mBlocks, [volume](int x, int y, int z, const BlockId *row) {
+        std::memcpy(&volume[Chunk::volumeIndex(x, y, z)], row,
+            BlockLayout::ROW_LENGTH * sizeof(BlockId));
+    });
+}
+
+void BlockStore::copyTo(BlockId *blocks) const
+{
+    if (mUniform)
+    {
+        for (int i = 0; i < BLOCK_COUNT; i++)
+        {
+            blocks[i] = mUniformBlock;
+        }
+
+        return;
+    }
+
+    if (BlockLayout::IS_LINEAR)
+    {
+        mBlocks.unpack(0, BLOCK_COUNT, blocks);
+        return;
+    }
+
+    forEachRow(mBlocks, [blocks](int x, int y, int z, const BlockId *row) {
+        std::memcpy(&blocks[BlockArrayLayout::index(x, y, z)], row,
+            BlockLayout::ROW_LENGTH * sizeof(BlockId));
+    });
+}
+
+size_t BlockStore::getMemoryUsage(void) const
+{
+    return sizeof(BlockStore) + (mUniform ? 0 : mBlocks.getMemoryUsage());
+}
+
+unsigned int BlockStore::getStoreCount(void)
+{
+    return mStores.size() + mUniformStores.size();
+}
+
+size_t BlockStore::getTotalMemoryUsage(void)
+{
+    return mTotalMemoryUsage;
+}
+
+void BlockStore::release(const BlockStore *store)
+{
+    mTotalMemoryUsage -= store->getMemoryUsage();
+
+    if (store->mUniform)
+    {
+        mUniformStores.erase(store->mUniformBlock);
+        delete store;
+        return;
+    }
+
+    auto range = mStores.equal_range(store->mHash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.store == store)
+        {
+            mStores.erase(it);
+            break;
+        }
+    }
+
+    delete store;
+}
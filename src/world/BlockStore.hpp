@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file BlockStore.hpp
+/// @brief An immutable array of blocks shared between chunks.
+///
+/// This file contains the BlockStore class. Chunks with identical contents
+/// share a single BlockStore, which collapses the memory used by repetitive
+/// terrain and by the empty chunks that make up most of the world.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_BLOCK_STORE_H_
+#define _CAMBRE_BLOCK_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "Block.hpp"
+#include "Chunk.hpp"
+#include "PaletteStorage.hpp"
+#include "VoxelLayout.hpp"
+
+/// @brief The order in which block stores keep their blocks.
+///
+/// The layout is chosen at compile time with the CAMBRE_BLOCK_LAYOUT option.
+#if defined(CAMBRE_BLOCK_LAYOUT_MORTON)
+typedef MortonLayout<Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y,
+    Chunk::CHUNK_SIZE_Z> BlockLayout;
+#elif defined(CAMBRE_BLOCK_LAYOUT_BRICK)
+typedef BrickLayout<Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y,
+    Chunk::CHUNK_SIZE_Z, 4> BlockLayout;
+#else
+typedef LinearLayout<Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y,
+    Chunk::CHUNK_SIZE_Z> BlockLayout;
+#endif
+
+/// @brief The [x][y][z] order used by the interface of BlockStore.
+typedef LinearLayout<Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y,
+    Chunk::CHUNK_SIZE_Z> BlockArrayLayout;
+
+/// @class BlockStore
+/// @brief An immutable array of blocks shared between chunks.
+///
+/// Block stores are content addressed: intern returns the existing store if
+/// one with the same blocks is alive, or creates a new one otherwise. Stores
+/// are reference counted and never modified, so a chunk that edits its blocks
+/// interns a modified copy instead (copy-on-write). A store is forgotten once
+/// the last reference to it is released.
+///
+/// The blocks are kept in a PaletteStorage. A store whose blocks are all the
+/// same type is uniform, and only keeps that type. Since stores are never
+/// modified, a uniform chunk is promoted to a full store by its first write of
+/// a different type.
+///
+/// The storage holds the blocks in the order of BlockLayout, while the
+/// interface always takes blocks in [x][y][z] order. Bulk copies walk the
+/// storage in layout order and move a row of blocks along z at a time.
+///
+/// Block stores are only created and released on the main thread.
+class BlockStore
+{
+public:
+    /// @brief The number of blocks in a store.
+    static const int BLOCK_COUNT = Chunk::BLOCK_COUNT;
+
+    /// @brief Gets the shared store holding a set of blocks.
+    ///
+    /// The blocks are BLOCK_COUNT types indexed by [x][y][z], with z
+    /// contiguous in memory.
+    static std::shared_ptr<const BlockStore> intern(const BlockId *blocks);
+
+    /// @brief Gets the shared store of a chunk filled with a single type.
+    ///
+    /// This does not require the blocks to be filled in first, which allows
+    /// generators to skip chunks they know to be uniform.
+    static std::shared_ptr<const BlockStore> internUniform(BlockId type);
+
+    /// @brief Gets the type of a block.
+    BlockId getBlock(int x, int y, int z) const
+    {
+        if (mUniform)
+        {
+            return mUniformBlock;
+        }
+
+        return mBlocks.get(BlockLayout::index(x, y, z));
+    }
+
+    /// @brief Copies the blocks of the store into a padded volume.
+    ///
+    /// This fills the blocks inside the border of a volume addressed by
+    /// Chunk::volumeIndex.
+    void copyToVolume(BlockId *volume) const;
+
+    /// @brief Copies the blocks of the store.
+    ///
+    /// The destination must hold BLOCK_COUNT blocks, which are indexed by
+    /// [x][y][z].
+    void copyTo(BlockId *blocks) const;
+
+    /// @brief Determines if every block of the store has the same type.
+    bool isUniform(void) const
+    {
+        return mUniform;
+    }
+
+    /// @brief Gets the number of bytes used by the store.
+    size_t getMemoryUsage(void) const;
+
+    /// @brief Gets the number of distinct stores that are alive.
+    static unsigned int getStoreCount(void);
+
+    /// @brief Gets the number of bytes used by the stores that are alive.
+    static size_t getTotalMemoryUsage(void);
+
+private:
+    /// @brief A struct containing an entry of the store table.
+    ///
+    /// The raw pointer identifies the entry when its store is released, at
+    /// which point the weak reference has already expired.
+    struct StoreEntryStruct
+    {
+        const BlockStore *store;
+        std::weak_ptr<const BlockStore> reference;
+    };
+
+    BlockStore(PaletteStorage &&blocks, uint64_t hash);
+    BlockStore(BlockId type);
+
+    /// @brief Deletes a store and removes it from the store table.
+    static void release(const BlockStore *store);
+
+    /// @brief The blocks of a full store.
+    PaletteStorage mBlocks;
+
+    /// @brief The type of every block of a uniform store.
+    BlockId mUniformBlock;
+
+    /// @brief A flag indicating the store is uniform.
+    bool mUniform;
+
+    /// @brief The hash of the blocks of a full store.
+    uint64_t mHash;
+
+    /// @brief The live full stores, keyed by the hash of their blocks.
+    static std::unordered_multimap<uint64_t, StoreEntryStruct> mStores;
+
+    /// @brief The live uniform stores, keyed by their type.
+    static std::unordered_map<BlockId, StoreEntryStruct> mUniformStores;
+
+    /// @brief The number of bytes used by the live stores.
+    ///
+    /// Stores never change, so the total is kept up to date as they are
+    /// created and released instead of being summed when it is read.
+    static size_t mTotalMemoryUsage;
+};
+
+#endif
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file CheckerboardGenerator.cpp
+/// @brief A generator of a flat test world.
+///
+/// This file contains the CheckerboardGenerator class. It fills every chunk
+/// below the ground with a lattice of stone blocks, which exposes the faces of
+/// every block and so makes a worst case for meshing.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "CheckerboardGenerator.hpp"
+#include "Chunk.hpp"
+
+CheckerboardGenerator::CheckerboardGenerator(void)
+{
+    mChunks = 0;
+}
+
+bool CheckerboardGenerator::generate(glm::ivec3 coords, BlockId *blocks)
+{
+    mChunks++;
+
+    // Chunks above the ground are empty, so they do not need to be filled.
+    if (coords.y > 0)
+    {
+        blocks[0] = Block::AIR;
+        return true;
+    }
+
+    for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++)
+    {
+        for (int y = 0; y < Chunk::CHUNK_SIZE_Y; y++)
+        {
+            for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++)
+            {
+                *blocks++ = ((x % 2 == 0) && (y % 2 == 0) && (z % 2 == 0))
+                    ? Block::STONE : Block::AIR;
+            }
+        }
+    }
+
+    return false;
+}
+
+void CheckerboardGenerator::printStatistics(void)
+{
+    std::cout << "Checkerboard: " << mChunks << " chunks generated"
+        << std::endl;
+}
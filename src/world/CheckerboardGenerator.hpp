@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file CheckerboardGenerator.hpp
+/// @brief A generator of a flat test world.
+///
+/// This file contains the CheckerboardGenerator class. It fills every chunk
+/// below the ground with a lattice of stone blocks, which exposes the faces of
+/// every block and so makes a worst case for meshing.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHECKERBOARD_GENERATOR_H_
+#define _CAMBRE_CHECKERBOARD_GENERATOR_H_
+
+#include <atomic>
+
+#include "ChunkGenerator.hpp"
+
+/// @class CheckerboardGenerator
+/// @brief A generator of a flat test world.
+///
+/// Chunks above the ground are empty. Chunks at or below it hold a stone block
+/// at every even coordinate, and since every such chunk is the same, they all
+/// share a single store.
+class CheckerboardGenerator : public ChunkGenerator
+{
+public:
+    CheckerboardGenerator(void);
+
+    bool generate(glm::ivec3 coords, BlockId *blocks);
+    void printStatistics(void);
+
+private:
+    /// @brief The number of chunks generated.
+    std::atomic<unsigned long> mChunks;
+};
+
+#endif
@@ -6,77 +6,206 @@
 /// responsible for rendering all the blocks via one call.
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
+#include "BlockStore.hpp"
 #include "CheckError.hpp"
 #include "Chunk.hpp"
+#include "ChunkMesh.hpp"
 
-Chunk::Chunk(void)
+unsigned long Chunk::mRevisionCounter = 0;
+
+// The number of blocks in the largest cell merged at a lower level of detail.
+static const int MAX_CELL_BLOCKS = 1 << (3 * (Chunk::LOD_LEVELS - 1));
+
+// Gets the level of detail that a chunk is drawn at. A chunk of a single type
+// looks the same at every level, so it is treated as full detail.
+static int drawnLod(Chunk &chunk)
 {
-    mVao = 0;
-    mVbo = 0;
-    mUpdateRequired = true;
-    mMeshElements = 0;
-    mNeighbors = {0};
-    mx = my = mz = 0;
+    return chunk.getBlockStore()->isUniform() ? 0 : chunk.getLod();
+}
+
+// Builds the key identifying the mesh of a chunk for a mode.
+static ChunkMesh::ChunkMeshKeyStruct meshKey(Chunk &chunk, int mode)
+{
+    ChunkMesh::ChunkMeshKeyStruct key;
+    key.mode = mode;
+    key.blocks = chunk.getBlockStore();
+    key.lod = drawnLod(chunk);
+
+    for (int dir = Chunk::pX; dir <= Chunk::nZ; dir++)
+    {
+        Chunk *neighbor =
+            chunk.getNeighbor(static_cast<Chunk::ChunkDirectionEnum>(dir));
+        key.neighborLods[dir] = 0;
+        if (neighbor != nullptr)
+        {
+            key.neighbors[dir] = neighbor->getBlockStore();
+            key.neighborLods[dir] = drawnLod(*neighbor);
+        }
+    }
+
+    return key;
+}
+
+// Finds the type that a cell of blocks is drawn as at a lower level of detail.
+// The cell is drawn as a cube if at least half of its blocks are cubes, using
+// the most common type of cube, so that thin terrain does not erode away.
+// Otherwise it is drawn as its most common other type, such as air. The cell
+// spans from the first to the last coordinates, exclusive, and a block is
+// found at the dot product of its coordinates and the stride.
+static BlockId findCellType(const BlockId *blocks, glm::ivec3 stride,
+    glm::ivec3 first, glm::ivec3 last)
+{
+    // A cell holds few distinct types, so they are counted in a short list.
+    BlockId types[MAX_CELL_BLOCKS];
+    int counts[MAX_CELL_BLOCKS];
+    int distinct = 0;
 
-    for (int x = 0; x < CHUNK_SIZE; x++)
+    for (int x = first.x; x < last.x; x++)
     {
-        for (int y = 0; y < CHUNK_SIZE; y++)
+        for (int y = first.y; y < last.y; y++)
         {
-            for (int z = 0; z < CHUNK_SIZE; z++)
+            const BlockId *row = blocks + x * stride.x + y * stride.y;
+            for (int z = first.z; z < last.z; z++)
             {
-                if (my > 0)
+                BlockId type = row[z * stride.z];
+                int i = 0;
+                while ((i < distinct) && (types[i] != type))
                 {
-                    mBlocks[x][y][z] = 0;
-                    continue;
+                    i++;
                 }
 
-                mBlocks[x][y][z] =
-                    ((x % 2 == 0) && (y % 2 == 0) && (z % 2 == 0)) ? 1 : 0;
+                if (i == distinct)
+                {
+                    types[distinct] = type;
+                    counts[distinct] = 0;
+                    distinct++;
+                }
+                counts[i]++;
             }
         }
     }
+
+    int cubes = 0;
+    for (int i = 0; i < distinct; i++)
+    {
+        if (Block::getShape(types[i]) == Block::SHAPE_CUBE)
+        {
+            cubes += counts[i];
+        }
+    }
+
+    glm::ivec3 size = last - first;
+    bool cube = (cubes * 2) >= (size.x * size.y * size.z);
+    int best = -1;
+    for (int i = 0; i < distinct; i++)
+    {
+        if (((Block::getShape(types[i]) == Block::SHAPE_CUBE) == cube) &&
+            ((best < 0) || (counts[i] > counts[best])))
+        {
+            best = i;
+        }
+    }
+
+    return types[best];
 }
 
-Chunk::Chunk(int x, int y, int z) : mx(x), my(y), mz(z)
+// Merges the blocks of a chunk in a padded volume into cells of a level of
+// detail. Each cell is filled with the type it is drawn as. Cells that would
+// cross the far side of the chunk are cut short.
+static void mergeVolume(BlockId *volume, int lod)
 {
-    mVao = 0;
-    mVbo = 0;
-    mUpdateRequired = true;
-    mMeshElements = 0;
-    mNeighbors = {0};
+    const int cell = 1 << lod;
+    const glm::ivec3 size = Chunk::getChunkSize();
+    const glm::ivec3 stride(Chunk::VOLUME_SIZE_Y * Chunk::VOLUME_SIZE_Z,
+        Chunk::VOLUME_SIZE_Z, 1);
+    BlockId *blocks = volume + Chunk::volumeIndex(0, 0, 0);
 
-    for (int x = 0; x < CHUNK_SIZE; x++)
+    for (int x = 0; x < size.x; x += cell)
     {
-        for (int y = 0; y < CHUNK_SIZE; y++)
+        for (int y = 0; y < size.y; y += cell)
         {
-            for (int z = 0; z < CHUNK_SIZE; z++)
+            for (int z = 0; z < size.z; z += cell)
             {
-                if (my > 0)
+                glm::ivec3 first(x, y, z);
+                glm::ivec3 last = glm::min(first + glm::ivec3(cell), size);
+                BlockId type = findCellType(blocks, stride, first, last);
+
+                for (int i = first.x; i < last.x; i++)
                 {
-                    mBlocks[x][y][z] = 0;
-                    continue;
+                    for (int j = first.y; j < last.y; j++)
+                    {
+                        for (int k = first.z; k < last.z; k++)
+                        {
+                            blocks[i * stride.x + j * stride.y + k] = type;
+                        }
+                    }
                 }
-
-                mBlocks[x][y][z] =
-                    ((x % 2 == 0) && (y % 2 == 0) && (z % 2 == 0)) ? 1 : 0;
             }
         }
     }
 }
 
+Chunk::Chunk(void)
+{
+    // Pools construct chunks in bulk, so a default constructed chunk starts
+    // out empty. reset fills the chunk once it is used.
+    mx = my = mz = 0;
+    mPool = nullptr;
+    mUpdateRequired = false;
+    mSaveRequired = false;
+    mMeshEvicted = false;
+    mRevision = ++mRevisionCounter;
+    mMeshingRevision = 0;
+    mMeshingMode = 0;
+    mLod = 0;
+    mNeighbors = {0};
+    mBlocks = BlockStore::internUniform(Block::AIR);
+}
+
 Chunk::~Chunk(void)
 {
-    if (mVao != 0)
-    {
-        glDeleteVertexArrays(1, &mVao);
-    }
+}
 
-    if (mVbo != 0)
-    {
-        glDeleteBuffers(1, &mVbo);
-    }
+void Chunk::reset(SlotMap<Chunk> *pool, int x, int y, int z,
+    std::shared_ptr<const BlockStore> blocks, bool saved)
+{
+    resetState(pool, x, y, z);
+
+    // Generated blocks are not in storage yet.
+    mBlocks = blocks;
+    mSaveRequired = !saved;
+}
+
+void Chunk::resetState(SlotMap<Chunk> *pool, int x, int y, int z)
+{
+    mx = x;
+    my = y;
+    mz = z;
+    mPool = pool;
+
+    // The new revision also invalidates any mesh of the chunk's previous
+    // contents that is still being generated.
+    mUpdateRequired = true;
+    mMeshEvicted = false;
+    mRevision = ++mRevisionCounter;
+    mMeshingRevision = 0;
+    mMeshingMode = 0;
+    mLod = 0;
+    mNeighbors = {0};
+    mMesh.reset();
+}
+
+void Chunk::clear(void)
+{
+    mBlocks = BlockStore::internUniform(Block::AIR);
+    mMesh.reset();
+    mNeighbors = {0};
+    mSaveRequired = false;
 }
 
 uint8_t Chunk::getNumNeighbors(void)
@@ -86,35 +215,30 @@ uint8_t Chunk::getNumNeighbors(void)
 
 bool Chunk::hasNeighbor(ChunkDirectionEnum dir)
 {
-    Chunk *neighbor = nullptr;
-
-    switch (dir)
-    {
-        case pX: neighbor = mNeighbors.posX; break;
-        case nX: neighbor = mNeighbors.negX; break;
-        case pY: neighbor = mNeighbors.posY; break;
-        case nY: neighbor = mNeighbors.negY; break;
-        case pZ: neighbor = mNeighbors.pozZ; break;
-        case nZ: neighbor = mNeighbors.negZ; break;
-    }
-
-    return (neighbor != nullptr) ? true : false;
+    return (getNeighbor(dir) != nullptr) ? true : false;
 }
 
 Chunk *Chunk::getNeighbor(ChunkDirectionEnum dir)
 {
+    if (mPool == nullptr)
+    {
+        return nullptr;
+    }
+
     switch (dir)
     {
-        case pX: return mNeighbors.posX;
-        case nX: return mNeighbors.negX;
-        case pY: return mNeighbors.posY;
-        case nY: return mNeighbors.negY;
-        case pZ: return mNeighbors.pozZ;
-        case nZ: return mNeighbors.negZ;
+        case pX: return mPool->get(mNeighbors.posX);
+        case nX: return mPool->get(mNeighbors.negX);
+        case pY: return mPool->get(mNeighbors.posY);
+        case nY: return mPool->get(mNeighbors.negY);
+        case pZ: return mPool->get(mNeighbors.pozZ);
+        case nZ: return mPool->get(mNeighbors.negZ);
     }
+
+    return nullptr;
 }
 
-void Chunk::setNeighbor(ChunkDirectionEnum dir, Chunk *n)
+void Chunk::setNeighbor(ChunkDirectionEnum dir, SlotHandleStruct n)
 {
     switch (dir)
     {
@@ -126,8 +250,12 @@ void Chunk::setNeighbor(ChunkDirectionEnum dir, Chunk *n)
         case nZ: mNeighbors.negZ = n; break;
     }
 
+    // The faces along the shared border may have been hidden or exposed, so
+    // the chunk needs to be meshed again.
+    requestUpdate();
+
     // Update the number of neighbors.
-    if (n == nullptr)
+    if (n.generation == 0)
     {
         mNeighbors.count--;
     }
@@ -137,120 +265,406 @@ void Chunk::setNeighbor(ChunkDirectionEnum dir, Chunk *n)
     }
 }
 
-glm::ivec3 Chunk::chunkCenterToWorldCoords(glm::ivec3 coords)
+void Chunk::requestUpdate(void)
 {
-    return (coords * CHUNK_SIZE) + glm::ivec3(CHUNK_SIZE / 2);
+    mUpdateRequired = true;
+    mRevision = ++mRevisionCounter;
 }
 
-void Chunk::initialize(void)
+bool Chunk::isUpdateRequired(void)
+{
+    return mUpdateRequired;
+}
+
+bool Chunk::isSaveRequired(void)
 {
-    glGenVertexArrays(1, &mVao);
-    glBindVertexArray(mVao);
+    return mSaveRequired;
+}
 
-    glGenBuffers(1, &mVbo);
+void Chunk::markSaved(void)
+{
+    mSaveRequired = false;
 }
 
-void Chunk::update(void)
+unsigned long Chunk::getRevision(void)
 {
-    if (!mUpdateRequired)
+    return mRevision;
+}
+
+bool Chunk::isMeshing(void)
+{
+    return mMeshingRevision != 0;
+}
+
+bool Chunk::shareMesh(int mode)
+{
+    // A chunk without any cubes has no faces, regardless of its neighbors, so
+    // it never needs a mesh.
+    if (mBlocks->isUniform() &&
+        (Block::getShape(mBlocks->getBlock(0, 0, 0)) != Block::SHAPE_CUBE))
     {
-        return;
+        mMesh.reset();
+        mUpdateRequired = false;
+
+        return true;
+    }
+
+    std::shared_ptr<ChunkMesh> mesh = ChunkMesh::find(meshKey(*this, mode));
+    if (!mesh)
+    {
+        return false;
     }
+
+    mMesh = mesh;
+    mUpdateRequired = false;
+
+    return true;
+}
+
+unsigned long Chunk::beginMeshing(BlockId *volume, int mode)
+{
+    gatherVolume(volume);
     mUpdateRequired = false;
+    mMeshingRevision = mRevision;
+    mMeshingMode = mode;
 
-    // Perform Meshing to generate the buffer data needed to render the chunk.
-    // Currently this uses a naive implementation of meshing; eventually, it
-    // will be updated to use greedy meshing.
-    // https://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
+    return mRevision;
+}
 
-    // The naive meshing implementation will generate 36 vertices for each voxel
-    // that is not empty.
-    int i = 0;
-    for (int x = 0; x < CHUNK_SIZE; x++)
+void Chunk::endMeshing(unsigned long revision,
+    const std::vector<uint32_t> &vertices)
+{
+    // Ignore meshes that were not requested by this chunk.
+    if (revision != mMeshingRevision)
     {
-        for (int y = 0; y < CHUNK_SIZE; y++)
+        return;
+    }
+    mMeshingRevision = 0;
+
+    // Discard the mesh if the chunk changed while it was being generated.
+    if (revision != mRevision)
+    {
+        return;
+    }
+
+    // The blocks and neighbors are unchanged since the volume was captured, so
+    // the key describes the mesh. Another chunk may have uploaded the same
+    // mesh while this one was being generated.
+    ChunkMesh::ChunkMeshKeyStruct key = meshKey(*this, mMeshingMode);
+    mMesh = ChunkMesh::find(key);
+    if (!mMesh)
+    {
+        mMesh = ChunkMesh::create(key, vertices);
+    }
+}
+
+BlockId Chunk::getBlock(int x, int y, int z)
+{
+    // Coordinates outside of this chunk are read from the neighboring chunk.
+    // Only one coordinate may be out of range at a time, and by at most one
+    // chunk. Missing neighbors are treated as empty.
+    Chunk *chunk = this;
+
+    if (x < 0)
+    {
+        chunk = getNeighbor(nX);
+        x += CHUNK_SIZE_X;
+    }
+    else if (x >= CHUNK_SIZE_X)
+    {
+        chunk = getNeighbor(pX);
+        x -= CHUNK_SIZE_X;
+    }
+    else if (y < 0)
+    {
+        chunk = getNeighbor(nY);
+        y += CHUNK_SIZE_Y;
+    }
+    else if (y >= CHUNK_SIZE_Y)
+    {
+        chunk = getNeighbor(pY);
+        y -= CHUNK_SIZE_Y;
+    }
+    else if (z < 0)
+    {
+        chunk = getNeighbor(nZ);
+        z += CHUNK_SIZE_Z;
+    }
+    else if (z >= CHUNK_SIZE_Z)
+    {
+        chunk = getNeighbor(pZ);
+        z -= CHUNK_SIZE_Z;
+    }
+
+    if (chunk == nullptr)
+    {
+        return 0;
+    }
+
+    return chunk->mBlocks->getBlock(x, y, z);
+}
+
+std::shared_ptr<const BlockStore> Chunk::getBlockStore(void)
+{
+    return mBlocks;
+}
+
+std::shared_ptr<ChunkMesh> Chunk::getMesh(void)
+{
+    return mMesh;
+}
+
+void Chunk::useMesh(std::shared_ptr<ChunkMesh> mesh)
+{
+    mMesh = mesh;
+}
+
+void Chunk::evictMesh(void)
+{
+    // The new revision discards a mesh that is still being generated, and the
+    // chunk needs a mesh once it is restored.
+    mMesh.reset();
+    mMeshEvicted = true;
+    mUpdateRequired = true;
+    mRevision = ++mRevisionCounter;
+}
+
+void Chunk::restoreMesh(void)
+{
+    mMeshEvicted = false;
+}
+
+bool Chunk::isMeshEvicted(void)
+{
+    return mMeshEvicted;
+}
+
+bool Chunk::setLod(int level)
+{
+    level = std::max(0, std::min(level, LOD_LEVELS - 1));
+    if (level == mLod)
+    {
+        return false;
+    }
+
+    mLod = level;
+    requestUpdate();
+
+    return true;
+}
+
+int Chunk::getLod(void)
+{
+    return mLod;
+}
+
+void Chunk::setBlock(int x, int y, int z, BlockId type)
+{
+    if (mBlocks->getBlock(x, y, z) == type)
+    {
+        return;
+    }
+
+    // The store may be shared, so edit a copy and share that instead.
+    BlockId blocks[CHUNK_SIZE_X][CHUNK_SIZE_Y][CHUNK_SIZE_Z];
+    mBlocks->copyTo(&blocks[0][0][0]);
+    blocks[x][y][z] = type;
+    mBlocks = BlockStore::intern(&blocks[0][0][0]);
+    mSaveRequired = true;
+
+    requestUpdate();
+
+    // Neighbors that touch the block have it in their border.
+    Chunk *neighbors[6] = {
+        (x == CHUNK_SIZE_X - 1) ? getNeighbor(pX) : nullptr,
+        (x == 0) ? getNeighbor(nX) : nullptr,
+        (y == CHUNK_SIZE_Y - 1) ? getNeighbor(pY) : nullptr,
+        (y == 0) ? getNeighbor(nY) : nullptr,
+        (z == CHUNK_SIZE_Z - 1) ? getNeighbor(pZ) : nullptr,
+        (z == 0) ? getNeighbor(nZ) : nullptr
+    };
+
+    for (int dir = 0; dir < 6; dir++)
+    {
+        if (neighbors[dir] != nullptr)
         {
-            for (int z = 0; z < CHUNK_SIZE; z++)
+            neighbors[dir]->requestUpdate();
+        }
+    }
+}
+
+void Chunk::gatherVolume(BlockId *volume)
+{
+    std::memset(volume, 0, VOLUME_BLOCK_COUNT * sizeof(BlockId));
+
+    // Decode this chunk's blocks in the order that they are stored.
+    mBlocks->copyToVolume(volume);
+    if (drawnLod(*this) > 0)
+    {
+        mergeVolume(volume, mLod);
+    }
+
+    // The neighbors drawn at a lower level of detail fill their faces of the
+    // border with the cells they draw.
+    Chunk *neighbors[6];
+    for (int dir = pX; dir <= nZ; dir++)
+    {
+        neighbors[dir] = getNeighbor(static_cast<ChunkDirectionEnum>(dir));
+        if ((neighbors[dir] != nullptr) && (drawnLod(*neighbors[dir]) > 0))
+        {
+            gatherMergedBorder(*neighbors[dir],
+                static_cast<ChunkDirectionEnum>(dir), volume);
+            neighbors[dir] = nullptr;
+        }
+    }
+
+    // Copy the faces of the other neighbors that touch this chunk into the
+    // border. The edges and corners of the border are not needed for meshing.
+    Chunk *negX = neighbors[nX];
+    Chunk *posX = neighbors[pX];
+    Chunk *negY = neighbors[nY];
+    Chunk *posY = neighbors[pY];
+    Chunk *negZ = neighbors[nZ];
+    Chunk *pozZ = neighbors[pZ];
+
+    for (int y = 0; y < CHUNK_SIZE_Y; y++)
+    {
+        for (int z = 0; z < CHUNK_SIZE_Z; z++)
+        {
+            if (negX != nullptr)
             {
-                uint8_t type = mBlocks[x][y][z];
+                volume[volumeIndex(-1, y, z)] =
+                    negX->mBlocks->getBlock(CHUNK_SIZE_X - 1, y, z);
+            }
 
-                // Do not add vertices for empty blocks.
-                if (type == 0)
-                {
-                    continue;
-                }
+            if (posX != nullptr)
+            {
+                volume[volumeIndex(CHUNK_SIZE_X, y, z)] =
+                    posX->mBlocks->getBlock(0, y, z);
+            }
+        }
+    }
 
-                // Add the 36 vertices to the mesh data.
-
-                // Negative X
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y+1, z,   type);
-
-                // Positive X
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y,   z+1, type);
-
-                // Negative Y
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y,   z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y,   z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z+1, type);
-
-                // Positive Y
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y+1, z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y+1, z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z,   type);
-
-                // Negative Z
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y+1, z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z,   type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y,   z,   type);
-
-                // Positive Z
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y,   z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y,   z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x+1, y+1, z+1, type);
-                mMeshData[i++] = glm::tvec4<GLbyte>(x,   y+1, z+1, type);
+    for (int x = 0; x < CHUNK_SIZE_X; x++)
+    {
+        for (int z = 0; z < CHUNK_SIZE_Z; z++)
+        {
+            if (negY != nullptr)
+            {
+                volume[volumeIndex(x, -1, z)] =
+                    negY->mBlocks->getBlock(x, CHUNK_SIZE_Y - 1, z);
+            }
+
+            if (posY != nullptr)
+            {
+                volume[volumeIndex(x, CHUNK_SIZE_Y, z)] =
+                    posY->mBlocks->getBlock(x, 0, z);
             }
         }
     }
 
-    mMeshElements = i;
-    glBindBuffer(GL_ARRAY_BUFFER, mVbo);
-    glBufferData(GL_ARRAY_BUFFER, mMeshElements * sizeof(*mMeshData), mMeshData,
-        GL_STATIC_DRAW);
+    for (int x = 0; x < CHUNK_SIZE_X; x++)
+    {
+        for (int y = 0; y < CHUNK_SIZE_Y; y++)
+        {
+            if (negZ != nullptr)
+            {
+                volume[volumeIndex(x, y, -1)] =
+                    negZ->mBlocks->getBlock(x, y, CHUNK_SIZE_Z - 1);
+            }
+
+            if (pozZ != nullptr)
+            {
+                volume[volumeIndex(x, y, CHUNK_SIZE_Z)] =
+                    pozZ->mBlocks->getBlock(x, y, 0);
+            }
+        }
+    }
 }
 
-void Chunk::render(void)
+void Chunk::gatherMergedBorder(Chunk &neighbor, ChunkDirectionEnum dir,
+    BlockId *volume)
 {
-    if (mMeshElements == 0)
+    // Only the layer of cells that touches this chunk is merged, so each cell
+    // is read from the neighbor's store on its own. The axes u and v run
+    // along the face.
+    BlockId blocks[MAX_CELL_BLOCKS];
+    const int cell = 1 << neighbor.mLod;
+    const glm::ivec3 size = getChunkSize();
+    int axis = dir / 2;
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    bool positive = (dir % 2) == 0;
+
+    glm::ivec3 first(0);
+    glm::ivec3 last(0);
+    first[axis] = positive ? 0 : ((size[axis] - 1) / cell) * cell;
+    last[axis] = std::min(first[axis] + cell, size[axis]);
+
+    glm::ivec3 border(0);
+    border[axis] = positive ? size[axis] : -1;
+
+    for (first[u] = 0; first[u] < size[u]; first[u] += cell)
     {
-        return;
+        for (first[v] = 0; first[v] < size[v]; first[v] += cell)
+        {
+            last[u] = std::min(first[u] + cell, size[u]);
+            last[v] = std::min(first[v] + cell, size[v]);
+
+            glm::ivec3 extent = last - first;
+            int i = 0;
+            for (int x = first.x; x < last.x; x++)
+            {
+                for (int y = first.y; y < last.y; y++)
+                {
+                    for (int z = first.z; z < last.z; z++)
+                    {
+                        blocks[i++] = neighbor.mBlocks->getBlock(x, y, z);
+                    }
+                }
+            }
+
+            BlockId type = findCellType(blocks,
+                glm::ivec3(extent.y * extent.z, extent.z, 1), glm::ivec3(0),
+                extent);
+
+            for (border[u] = first[u]; border[u] < last[u]; border[u]++)
+            {
+                for (border[v] = first[v]; border[v] < last[v]; border[v]++)
+                {
+                    volume[volumeIndex(border.x, border.y, border.z)] = type;
+                }
+            }
+        }
     }
+}
 
-    glEnableVertexAttribArray(0);
+glm::ivec3 Chunk::chunkCenterToWorldCoords(glm::ivec3 coords)
+{
+    return (coords * getChunkSize()) + (getChunkSize() / 2);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, mVbo);
-    glVertexAttribPointer(0, 4, GL_BYTE, GL_FALSE, 0, 0);
-    glDrawArrays(GL_TRIANGLES, 0, mMeshElements);
+glm::ivec3 Chunk::worldToChunkCoords(glm::vec3 position)
+{
+    return glm::ivec3(glm::floor(position / glm::vec3(getChunkSize())));
+}
+
+void Chunk::initialize(void)
+{
+    // The OpenGL objects are owned by the shared ChunkMesh, which is created
+    // once the chunk has been meshed.
+}
+
+void Chunk::update(void)
+{
+    // Chunks are meshed by the MeshWorkerPool of their Region, which hands
+    // the finished mesh back through endMeshing.
+}
 
-    glDisableVertexAttribArray(0);
+void Chunk::render(void)
+{
+    if (mMesh)
+    {
+        mMesh->render();
+    }
 }
@@ -10,18 +10,40 @@
 #define _CAMBRE_CHUNK_H_
 
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "Block.hpp"
 #include "DynamicObjectInterface.hpp"
+#include "SlotMap.hpp"
+
+class BlockStore;
+class ChunkMesh;
+
+// The dimensions of a chunk in blocks, which are set by the build.
+#ifndef CAMBRE_CHUNK_SIZE_X
+#define CAMBRE_CHUNK_SIZE_X 16
+#endif
+
+#ifndef CAMBRE_CHUNK_SIZE_Y
+#define CAMBRE_CHUNK_SIZE_Y 16
+#endif
+
+#ifndef CAMBRE_CHUNK_SIZE_Z
+#define CAMBRE_CHUNK_SIZE_Z 16
+#endif
 
 /// @class Chunk
 /// @brief A class to store several blocks.
 ///
 /// This class groups related blocks into a single unit for the GPU to render.
-/// The number of blocks is determined by the static variable CHUNK_SIZE.
+/// The number of blocks along each axis is fixed at compile time by
+/// CHUNK_SIZE_X, CHUNK_SIZE_Y and CHUNK_SIZE_Z, so every loop over the blocks
+/// of a chunk has constant bounds.
 class Chunk : public DynamicObjectInterface
 {
 public:
@@ -44,57 +66,275 @@ public:
     ///
     /// This struct contains all the necessary information about the chunk's
     /// neighbors. It must be maintained by the system that loads/unloads
-    /// chunks. The pointers are null when a chunk's neighbor is not a part of
-    /// the region.
+    /// chunks. The neighbors are handles into the chunk's pool, and are null
+    /// when a chunk's neighbor is not a part of the region.
     struct ChunkNeighborsStruct
     {
         uint8_t count;
-        Chunk *posX;
-        Chunk *negX;
-        Chunk *posY;
-        Chunk *negY;
-        Chunk *pozZ;
-        Chunk *negZ;
+        SlotHandleStruct posX;
+        SlotHandleStruct negX;
+        SlotHandleStruct posY;
+        SlotHandleStruct negY;
+        SlotHandleStruct pozZ;
+        SlotHandleStruct negZ;
     };
 
     Chunk(void);
-    Chunk(int x, int y, int z);
     virtual ~Chunk(void);
     void initialize(void);
     void update(void);
     void render(void);
 
+    /// @brief Reinitializes the chunk at new coordinates with new blocks.
+    ///
+    /// This allows a chunk object to be recycled by a pool instead of being
+    /// deleted and allocated again. The chunk's neighbors are resolved through
+    /// the pool; a chunk without a pool has no neighbors. The blocks are
+    /// either read from storage, in which case the chunk starts out saved, or
+    /// freshly generated.
+    void reset(SlotMap<Chunk> *pool, int x, int y, int z,
+        std::shared_ptr<const BlockStore> blocks, bool saved);
+
+    /// @brief Releases the blocks and mesh of the chunk.
+    ///
+    /// This is called when the chunk is returned to its pool, so that the
+    /// shared blocks and mesh are not kept alive by an unused chunk. The chunk
+    /// is left empty.
+    void clear(void);
+
     uint8_t getNumNeighbors(void);
     bool hasNeighbor(ChunkDirectionEnum dir);
     Chunk *getNeighbor(ChunkDirectionEnum dir);
-    void setNeighbor(ChunkDirectionEnum dir, Chunk *n);
+    void setNeighbor(ChunkDirectionEnum dir, SlotHandleStruct n);
+
+    /// @brief Marks the chunk to be meshed again.
+    ///
+    /// This gives the chunk a new revision, so any mesh that is still being
+    /// generated from the old contents will be discarded.
+    void requestUpdate(void);
+
+    /// @brief Determines if the chunk needs to be meshed.
+    bool isUpdateRequired(void);
+
+    /// @brief Determines if the blocks differ from the saved blocks.
+    ///
+    /// Generated chunks and edited chunks need to be saved.
+    bool isSaveRequired(void);
+
+    /// @brief Marks the blocks as saved.
+    void markSaved(void);
+
+    /// @brief Gets the revision of the chunk's contents.
+    ///
+    /// Revisions are unique across all chunks, so a revision identifies both
+    /// the chunk and the state of its blocks and neighbors.
+    unsigned long getRevision(void);
+
+    /// @brief Determines if a mesh of the chunk is being generated.
+    bool isMeshing(void);
+
+    /// @brief Shares the mesh of an identical chunk.
+    ///
+    /// If a chunk with the same blocks and neighbors has already been meshed
+    /// with the mode, this chunk uses that mesh and no longer needs to be
+    /// meshed. Chunks without any cubes never need a mesh. This function must
+    /// be called on the thread that owns the OpenGL context.
+    ///
+    /// @returns True if a mesh was shared.
+    bool shareMesh(int mode);
+
+    /// @brief Captures the chunk's contents for meshing.
+    ///
+    /// This function fills the volume via gatherVolume and clears the update
+    /// flag. The volume can then be meshed on another thread with the mode.
+    ///
+    /// @returns The revision that the volume was captured from.
+    unsigned long beginMeshing(BlockId *volume, int mode);
+
+    /// @brief Finishes meshing the chunk.
+    ///
+    /// This function accepts the mesh generated from a volume captured by
+    /// beginMeshing. The mesh is uploaded only if the chunk has not changed
+    /// since the volume was captured; otherwise it is discarded and the chunk
+    /// will be captured again. If an identical chunk uploaded the same mesh in
+    /// the meantime, that mesh is shared instead. This function must be called
+    /// on the thread that owns the OpenGL context.
+    void endMeshing(unsigned long revision,
+        const std::vector<uint32_t> &vertices);
+
+    /// @brief Gets the type of a block relative to this chunk.
+    ///
+    /// This function returns the block at the local coordinates. Coordinates
+    /// that fall just outside of the chunk are looked up in the neighboring
+    /// chunk; if that neighbor is not loaded, the block is treated as empty.
+    BlockId getBlock(int x, int y, int z);
+
+    /// @brief Gets the shared store of the chunk's blocks.
+    std::shared_ptr<const BlockStore> getBlockStore(void);
+
+    /// @brief Gets the mesh drawn for the chunk.
+    ///
+    /// The mesh is null if the chunk has no faces or has not been meshed.
+    std::shared_ptr<ChunkMesh> getMesh(void);
+
+    /// @brief Draws a mesh until the chunk is meshed again.
+    ///
+    /// This is used to restore the mesh of a chunk that is loaded again. The
+    /// chunk still needs to be meshed, but if the mesh matches its blocks and
+    /// neighbors, shareMesh finds it without generating a new one.
+    void useMesh(std::shared_ptr<ChunkMesh> mesh);
+
+    /// @brief Drops the chunk's mesh to free video memory.
+    ///
+    /// The blocks are kept, but the chunk is not drawn or meshed until
+    /// restoreMesh is called. Any mesh that is still being generated is
+    /// discarded.
+    void evictMesh(void);
 
-    static const int CHUNK_SIZE = 16;
+    /// @brief Allows an evicted chunk to be meshed again.
+    void restoreMesh(void);
+
+    /// @brief Determines if the chunk's mesh has been evicted.
+    bool isMeshEvicted(void);
+
+    /// @brief Sets the level of detail that the chunk is meshed at.
+    ///
+    /// At level n, each cell of 2^n blocks along every axis is drawn as one
+    /// large block of the cell's majority type. The chunk is marked to be
+    /// meshed again if the level changes. The neighbors mesh their borders
+    /// against the blocks this chunk draws, so they need to be meshed again
+    /// as well. The level is clamped to the levels that exist.
+    ///
+    /// @returns True if the level changed.
+    bool setLod(int level);
+
+    /// @brief Gets the level of detail that the chunk is meshed at.
+    int getLod(void);
+
+    /// @brief Sets the type of a block in this chunk.
+    ///
+    /// The blocks of a chunk may be shared with other chunks, so the edit is
+    /// made to a copy of the blocks (copy-on-write). The chunk and any
+    /// neighbors that touch the block are marked to be meshed again.
+    void setBlock(int x, int y, int z, BlockId type);
+
+    /// @brief Copies the blocks needed to mesh the chunk into a volume.
+    ///
+    /// The volume is a box of VOLUME_SIZE_X by VOLUME_SIZE_Y by VOLUME_SIZE_Z
+    /// blocks that holds this chunk's blocks surrounded by a one block border.
+    /// The border is filled with the adjacent blocks of the neighboring
+    /// chunks, or left empty if a neighbor is not loaded. Use volumeIndex to
+    /// address the volume.
+    ///
+    /// The blocks are merged into cells at the chunk's level of detail. The
+    /// border holds the neighbors' blocks as they are drawn at their own
+    /// levels, so a face on the border is only hidden by a block that the
+    /// neighbor actually draws, and no gaps open between chunks at different
+    /// levels.
+    void gatherVolume(BlockId *volume);
+
+    /// @brief The number of blocks along each axis of a chunk.
+    static const int CHUNK_SIZE_X = CAMBRE_CHUNK_SIZE_X;
+    static const int CHUNK_SIZE_Y = CAMBRE_CHUNK_SIZE_Y;
+    static const int CHUNK_SIZE_Z = CAMBRE_CHUNK_SIZE_Z;
+
+    /// @brief The number of blocks in a chunk.
+    static const int BLOCK_COUNT = CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z;
+
+    /// @brief The number of levels of detail, including full detail.
+    ///
+    /// Each level doubles the size of the cells that the blocks are merged
+    /// into, so the coarsest level merges cells of 8 blocks along each axis.
+    static const int LOD_LEVELS = 4;
+
+    /// @brief The size of a padded volume filled by gatherVolume.
+    static const int VOLUME_SIZE_X = CHUNK_SIZE_X + 2;
+    static const int VOLUME_SIZE_Y = CHUNK_SIZE_Y + 2;
+    static const int VOLUME_SIZE_Z = CHUNK_SIZE_Z + 2;
+
+    /// @brief The number of blocks in a padded volume.
+    static const int VOLUME_BLOCK_COUNT =
+        VOLUME_SIZE_X * VOLUME_SIZE_Y * VOLUME_SIZE_Z;
+
+    static_assert((CHUNK_SIZE_X > 0) && (CHUNK_SIZE_Y > 0) &&
+        (CHUNK_SIZE_Z > 0), "A chunk must hold at least one block");
+
+    /// @brief Gets the number of blocks along each axis of a chunk.
+    static glm::ivec3 getChunkSize(void)
+    {
+        return glm::ivec3(CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SIZE_Z);
+    }
+
+    /// @brief Gets the index of a block in a padded volume.
+    ///
+    /// The coordinates are local to the chunk and range from -1 to the size
+    /// of the chunk along each axis inclusive. The z axis is contiguous in
+    /// memory.
+    static int volumeIndex(int x, int y, int z)
+    {
+        return (((x + 1) * VOLUME_SIZE_Y) + (y + 1)) * VOLUME_SIZE_Z +
+            (z + 1);
+    }
 
     static glm::ivec3 chunkCenterToWorldCoords(glm::ivec3 coords);
 
+    /// @brief Gets the coordinates of the chunk containing a world position.
+    static glm::ivec3 worldToChunkCoords(glm::vec3 position);
+
 private:
     /// @brief The coordinates of this chunk in the world.
     int mx;
     int my;
     int mz;
 
-    /// @brief The array of blocks belonging to this chunk.
-    uint8_t mBlocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
+    /// @brief The pool that the chunk and its neighbors belong to.
+    SlotMap<Chunk> *mPool;
 
-    /// @brief The OpenGL Vertex Array Object
-    GLuint mVao;
-
-    /// @brief The OpenGL Vertex Buffer Object
-    GLuint mVbo;
+    /// @brief The blocks belonging to this chunk.
+    ///
+    /// The store is shared by every chunk with the same blocks.
+    std::shared_ptr<const BlockStore> mBlocks;
 
-    /// @brief The Mesh Data for the VBO.
-    glm::tvec4<GLbyte> mMeshData[CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 36];
-    int mMeshElements;
+    /// @brief The mesh drawn for this chunk.
+    ///
+    /// The mesh is shared by every chunk with the same blocks and neighbors.
+    std::shared_ptr<ChunkMesh> mMesh;
 
     /// @brief A flag indicating updates need to occur.
     bool mUpdateRequired;
 
+    /// @brief A flag indicating the blocks have not been saved.
+    bool mSaveRequired;
+
+    /// @brief A flag indicating the mesh was evicted from video memory.
+    bool mMeshEvicted;
+
+    /// @brief The revision of the chunk's contents.
+    unsigned long mRevision;
+
+    /// @brief The revision being meshed, or 0 if no mesh is being generated.
+    unsigned long mMeshingRevision;
+
+    /// @brief The mode of the mesh being generated.
+    int mMeshingMode;
+
+    /// @brief The level of detail that the chunk is meshed at.
+    int mLod;
+
+    /// @brief The last revision handed out to any chunk.
+    ///
+    /// Chunks are only modified on the main thread, so the counter does not
+    /// need to be synchronized.
+    static unsigned long mRevisionCounter;
+
+    /// @brief Resets the state of the chunk for new coordinates.
+    void resetState(SlotMap<Chunk> *pool, int x, int y, int z);
+
+    /// @brief Fills the face of a volume's border that touches a neighbor
+    /// with the cells that the neighbor draws at its level of detail.
+    void gatherMergedBorder(Chunk &neighbor, ChunkDirectionEnum dir,
+        BlockId *volume);
+
     /// @brief The information about neighboring chunks.
     ///
     /// This struct stores information about the neighboring chunks, which
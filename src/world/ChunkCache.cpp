@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkCache.cpp
+/// @brief A cache of recently unloaded chunks.
+///
+/// This file contains the ChunkCache class. It keeps the blocks and meshes of
+/// the chunks that were unloaded last, so that a camera returning to them can
+/// load them again without generating or meshing them.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "ChunkCache.hpp"
+
+ChunkCache::ChunkCache(unsigned int capacity)
+{
+    mCapacity = capacity;
+    mHits = 0;
+    mDrops = 0;
+}
+
+void ChunkCache::insert(glm::ivec3 coords, const CachedChunkStruct &chunk)
+{
+    std::list<CacheEntryStruct>::iterator *entry = mIndex.find(coords);
+    if (entry != nullptr)
+    {
+        mEntries.erase(*entry);
+        mIndex.erase(coords);
+    }
+
+    if (mCapacity == 0)
+    {
+        return;
+    }
+
+    // Drop the least recently added chunk to make room.
+    if (mEntries.size() >= mCapacity)
+    {
+        mIndex.erase(mEntries.back().coords);
+        mEntries.pop_back();
+        mDrops++;
+    }
+
+    mEntries.push_front(CacheEntryStruct{coords, chunk});
+    mIndex.insert(coords, mEntries.begin());
+}
+
+bool ChunkCache::take(glm::ivec3 coords, CachedChunkStruct &chunk)
+{
+    std::list<CacheEntryStruct>::iterator *entry = mIndex.find(coords);
+    if (entry == nullptr)
+    {
+        return false;
+    }
+
+    chunk = std::move((*entry)->chunk);
+    mEntries.erase(*entry);
+    mIndex.erase(coords);
+    mHits++;
+
+    return true;
+}
+
+void ChunkCache::clear(void)
+{
+    mDrops += mEntries.size();
+    mEntries.clear();
+    mIndex.clear();
+}
+
+unsigned int ChunkCache::trim(unsigned int count)
+{
+    unsigned int dropped = 0;
+    while ((dropped < count) && !mEntries.empty())
+    {
+        mIndex.erase(mEntries.back().coords);
+        mEntries.pop_back();
+        dropped++;
+    }
+    mDrops += dropped;
+
+    return dropped;
+}
+
+void ChunkCache::releaseMeshes(void)
+{
+    for (CacheEntryStruct &entry : mEntries)
+    {
+        entry.chunk.mesh.reset();
+        for (int i = 0; i < 6; i++)
+        {
+            entry.chunk.neighbors[i].mesh.reset();
+        }
+    }
+}
+
+bool ChunkCache::contains(glm::ivec3 coords)
+{
+    return mIndex.find(coords) != nullptr;
+}
+
+unsigned int ChunkCache::size(void)
+{
+    return mIndex.size();
+}
+
+void ChunkCache::printStatistics(void)
+{
+    std::cout << "Cache: " << mHits << " chunks revived, " << mDrops
+        << " chunks dropped, " << size() << " of " << mCapacity
+        << " chunks cached" << std::endl;
+}
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkCache.hpp
+/// @brief A cache of recently unloaded chunks.
+///
+/// This file contains the ChunkCache class. It keeps the blocks and meshes of
+/// the chunks that were unloaded last, so that a camera returning to them can
+/// load them again without generating or meshing them.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHUNK_CACHE_H_
+#define _CAMBRE_CHUNK_CACHE_H_
+
+#include <list>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "BlockStore.hpp"
+#include "ChunkMesh.hpp"
+#include "CoordinateMap.hpp"
+
+/// @class ChunkCache
+/// @brief A cache of recently unloaded chunks.
+///
+/// Each entry holds the blocks and mesh of an unloaded chunk, along with the
+/// meshes that its neighbors had while it was loaded. Holding the meshes keeps
+/// them alive, so once the chunk and its neighbors are connected again they
+/// share the same meshes instead of being meshed. The least recently unloaded
+/// chunk is dropped once the cache is full.
+class ChunkCache
+{
+public:
+    /// @brief A struct containing the mesh of a neighbor of a cached chunk.
+    ///
+    /// The revision is the neighbor's revision after the cached chunk was
+    /// disconnected. If the neighbor still has that revision when the chunk
+    /// is loaded again, nothing else about it has changed and the mesh is
+    /// still valid.
+    struct CachedNeighborStruct
+    {
+        std::shared_ptr<ChunkMesh> mesh;
+        unsigned long revision;
+    };
+
+    /// @brief A struct containing a cached chunk.
+    ///
+    /// The neighbors are indexed by Chunk::ChunkDirectionEnum, and have a null
+    /// mesh when the neighbor was not loaded.
+    struct CachedChunkStruct
+    {
+        std::shared_ptr<const BlockStore> blocks;
+        std::shared_ptr<ChunkMesh> mesh;
+        CachedNeighborStruct neighbors[6];
+    };
+
+    /// @brief Constructs a cache holding up to capacity chunks.
+    ChunkCache(unsigned int capacity);
+
+    /// @brief Adds an unloaded chunk to the cache.
+    ///
+    /// A previous entry for the coordinates is replaced. The least recently
+    /// added chunk is dropped if the cache is full.
+    void insert(glm::ivec3 coords, const CachedChunkStruct &chunk);
+
+    /// @brief Removes a chunk from the cache.
+    ///
+    /// @returns True if the chunk was cached and moved into chunk.
+    bool take(glm::ivec3 coords, CachedChunkStruct &chunk);
+
+    /// @brief Drops every cached chunk.
+    void clear(void);
+
+    /// @brief Drops up to a number of the least recently added chunks.
+    ///
+    /// @returns The number of chunks dropped.
+    unsigned int trim(unsigned int count);
+
+    /// @brief Drops the meshes of the cached chunks but keeps their blocks.
+    ///
+    /// The chunks are meshed again if they are loaded.
+    void releaseMeshes(void);
+
+    /// @brief Determines if a chunk is cached.
+    bool contains(glm::ivec3 coords);
+
+    /// @brief Gets the number of cached chunks.
+    unsigned int size(void);
+
+    /// @brief Prints the number of chunks revived and dropped.
+    void printStatistics(void);
+
+private:
+    /// @brief A struct containing an entry of the cache.
+    struct CacheEntryStruct
+    {
+        glm::ivec3 coords;
+        CachedChunkStruct chunk;
+    };
+
+    /// @brief The maximum number of cached chunks.
+    unsigned int mCapacity;
+
+    /// @brief The cached chunks, most recently added first.
+    std::list<CacheEntryStruct> mEntries;
+
+    /// @brief The entry of each cached chunk.
+    CoordinateMap<std::list<CacheEntryStruct>::iterator> mIndex;
+
+    /// @brief The number of chunks taken from and dropped by the cache.
+    unsigned long mHits;
+    unsigned long mDrops;
+};
+
+#endif
@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkGenerator.hpp
+/// @brief The interface used by the Region class to generate chunks.
+///
+/// This file defines the interface that fills the chunks that have never been
+/// saved. A generator is attached to a region via useGenerator. The region
+/// generates chunks as jobs on its job system, so a generator is called from
+/// several worker threads at once and must be thread safe.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHUNK_GENERATOR_H_
+#define _CAMBRE_CHUNK_GENERATOR_H_
+
+#include <glm/glm.hpp>
+
+#include "Block.hpp"
+
+class ChunkGenerator
+{
+public:
+    virtual ~ChunkGenerator(void) {}
+
+    /// @brief Generates the blocks of the chunk at the chunk coordinates.
+    ///
+    /// The blocks are Chunk::BLOCK_COUNT types indexed by [x][y][z], with z
+    /// contiguous in memory. A generator that knows the chunk is a single type
+    /// may set only the first block and return true, so that the chunk is not
+    /// filled block by block.
+    ///
+    /// @returns True if the chunk is a single type.
+    virtual bool generate(glm::ivec3 coords, BlockId *blocks) = 0;
+
+    /// @brief Prints the number of chunks generated and the time spent.
+    virtual void printStatistics(void) = 0;
+};
+
+#endif
@@ -0,0 +1,305 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkLoader.cpp
+/// @brief A background thread that reads and writes saved chunks.
+///
+/// This file contains the ChunkLoader class. It moves the file accesses of
+/// ChunkStorage off of the main thread, so that reading a chunk from disk does
+/// not stall the main loop.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "Chunk.hpp"
+#include "ChunkLoader.hpp"
+#include "RegionFile.hpp"
+
+// The number of spare block buffers kept for new results. Buffers returned
+// beyond this are released.
+static const unsigned int FREE_BLOCK_BUFFERS = 8;
+
+ChunkLoader::ChunkLoader(void)
+{
+    mEnabled = false;
+    mPendingReads = 0;
+    mBusy = false;
+    mStopping = false;
+    mReads = 0;
+    mPrefetchReads = 0;
+
+    mThread = std::thread(&ChunkLoader::work, this);
+}
+
+ChunkLoader::~ChunkLoader(void)
+{
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mJobAvailable.notify_all();
+
+    mThread.join();
+}
+
+void ChunkLoader::setDirectory(const std::string &directory)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStorage.setDirectory(directory);
+    mEnabled = mStorage.isEnabled();
+}
+
+bool ChunkLoader::isEnabled(void)
+{
+    return mEnabled;
+}
+
+bool ChunkLoader::request(glm::ivec3 coords, bool prefetch)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        PendingStateEnum *state = mPending.find(coords);
+        if (state != nullptr)
+        {
+            if (prefetch ||
+                ((*state != QUEUED_PREFETCH) && (*state != READING_PREFETCH)))
+            {
+                return false;
+            }
+
+            // Promote the prefetch. A prefetch that has not started is queued
+            // again with the demanded reads, and the stale prefetch is skipped.
+            mPendingReads++;
+            if (*state == READING_PREFETCH)
+            {
+                *state = READING;
+                return true;
+            }
+
+            *state = QUEUED_READ;
+            mJobs.push_back(LoadJobStruct{coords, READ,
+                std::vector<uint8_t>()});
+        }
+        else if (prefetch)
+        {
+            mPending.insert(coords, QUEUED_PREFETCH);
+            mPrefetches.push_back(coords);
+        }
+        else
+        {
+            mPendingReads++;
+            mPending.insert(coords, QUEUED_READ);
+            mJobs.push_back(LoadJobStruct{coords, READ,
+                std::vector<uint8_t>()});
+        }
+    }
+    mJobAvailable.notify_one();
+
+    return true;
+}
+
+void ChunkLoader::clearPrefetches(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (const glm::ivec3 &coords : mPrefetches)
+    {
+        PendingStateEnum *state = mPending.find(coords);
+        if ((state != nullptr) && (*state == QUEUED_PREFETCH))
+        {
+            mPending.erase(coords);
+        }
+    }
+    mPrefetches.clear();
+}
+
+void ChunkLoader::save(glm::ivec3 coords, const BlockStore &blocks)
+{
+    LoadJobStruct job;
+    job.coords = coords;
+    job.type = WRITE;
+
+    // Encode outside of the lock; only the main thread touches block stores.
+    RegionFile::encode(blocks, job.payload);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mJobAvailable.notify_one();
+}
+
+bool ChunkLoader::collect(LoadResultStruct &result)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mResults.empty())
+    {
+        return false;
+    }
+
+    result = std::move(mResults.front());
+    mResults.pop_front();
+
+    return true;
+}
+
+void ChunkLoader::recycle(LoadResultStruct &result)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mFreeBlocks.size() < FREE_BLOCK_BUFFERS)
+    {
+        mFreeBlocks.push_back(std::move(result.blocks));
+    }
+
+    result.blocks = std::vector<BlockId>();
+}
+
+unsigned int ChunkLoader::getPendingReads(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPendingReads;
+}
+
+size_t ChunkLoader::getMemoryUsage(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t bytes = 0;
+
+    for (const LoadJobStruct &job : mJobs)
+    {
+        bytes += job.payload.capacity();
+    }
+
+    for (const LoadResultStruct &result : mResults)
+    {
+        bytes += result.blocks.capacity() * sizeof(BlockId);
+    }
+
+    for (const std::vector<BlockId> &blocks : mFreeBlocks)
+    {
+        bytes += blocks.capacity() * sizeof(BlockId);
+    }
+
+    return bytes;
+}
+
+void ChunkLoader::flush(void)
+{
+    clearPrefetches();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdle.wait(lock, [this] {
+        return mJobs.empty() && !mBusy;
+    });
+}
+
+void ChunkLoader::printStatistics(void)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::cout << "Loader: " << mReads << " chunks read on demand, "
+            << mPrefetchReads << " chunks prefetched" << std::endl;
+    }
+
+    mStorage.printStatistics();
+}
+
+void ChunkLoader::work(void)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        if (mJobs.empty())
+        {
+            mIdle.notify_all();
+        }
+
+        mJobAvailable.wait(lock, [this] {
+            return mStopping || !mJobs.empty() || !mPrefetches.empty();
+        });
+
+        if (mStopping)
+        {
+            break;
+        }
+
+        // Prefetches wait until every write and demanded read is done.
+        LoadJobStruct job;
+        bool prefetch = mJobs.empty();
+        if (prefetch)
+        {
+            job.coords = mPrefetches.front();
+            job.type = READ;
+            mPrefetches.pop_front();
+        }
+        else
+        {
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        if (job.type == WRITE)
+        {
+            mBusy = true;
+            lock.unlock();
+            mStorage.save(job.coords, job.payload);
+            lock.lock();
+            mBusy = false;
+            continue;
+        }
+
+        // Skip prefetches that were dropped or promoted since they were
+        // queued.
+        PendingStateEnum *state = mPending.find(job.coords);
+        if ((state == nullptr) ||
+            (*state != (prefetch ? QUEUED_PREFETCH : QUEUED_READ)))
+        {
+            continue;
+        }
+        *state = prefetch ? READING_PREFETCH : READING;
+
+        LoadResultStruct result;
+        result.coords = job.coords;
+        result.uniform = false;
+        if (!mFreeBlocks.empty())
+        {
+            result.blocks = std::move(mFreeBlocks.back());
+            mFreeBlocks.pop_back();
+        }
+
+        // Read and decode without holding the lock.
+        mBusy = true;
+        lock.unlock();
+        result.blocks.resize(Chunk::BLOCK_COUNT);
+        result.found = mStorage.load(job.coords, result.blocks.data(),
+            result.uniform);
+        lock.lock();
+        mBusy = false;
+
+        // The read may have been demanded while it was in progress.
+        if (*mPending.find(job.coords) == READING)
+        {
+            mPendingReads--;
+        }
+        mPending.erase(job.coords);
+
+        if (prefetch)
+        {
+            mPrefetchReads++;
+        }
+        else
+        {
+            mReads++;
+        }
+
+        mResults.push_back(std::move(result));
+    }
+}
@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkLoader.hpp
+/// @brief A background thread that reads and writes saved chunks.
+///
+/// This file contains the ChunkLoader class. It moves the file accesses of
+/// ChunkStorage off of the main thread, so that reading a chunk from disk does
+/// not stall the main loop.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHUNK_LOADER_H_
+#define _CAMBRE_CHUNK_LOADER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Block.hpp"
+#include "BlockStore.hpp"
+#include "ChunkStorage.hpp"
+#include "CoordinateMap.hpp"
+
+/// @class ChunkLoader
+/// @brief A background thread that reads and writes saved chunks.
+///
+/// The main thread requests chunks with request, and the loader thread reads
+/// and decodes them. The decoded blocks are handed back through collect, and
+/// the main thread interns them, since block stores may only be created on the
+/// main thread. Saves are encoded on the main thread and written by the loader
+/// thread.
+///
+/// Requests are either demanded, for chunks that are about to be loaded, or
+/// prefetched, for chunks the camera is expected to reach. Writes and demanded
+/// reads are processed in the order they are made, so a chunk is always read
+/// after its last save. Prefetches are only processed when no other work is
+/// waiting, and can be dropped all at once when the prediction changes. Each
+/// chunk is pending at most once; demanding a prefetched chunk promotes it.
+class ChunkLoader
+{
+public:
+    /// @brief A struct containing a finished read.
+    ///
+    /// If the chunk was not found, it has never been saved and should be
+    /// generated. The blocks are decoded as described by RegionFile::decode.
+    struct LoadResultStruct
+    {
+        glm::ivec3 coords;
+        bool found;
+        bool uniform;
+        std::vector<BlockId> blocks;
+    };
+
+    /// @brief The default constructor.
+    ///
+    /// Starts the loader thread. Storage is disabled until a directory is
+    /// set.
+    ChunkLoader(void);
+
+    /// @brief The default destructor.
+    ///
+    /// Finishes the queued jobs, then stops and joins the loader thread.
+    ~ChunkLoader(void);
+
+    /// @brief Sets the directory that the chunks are saved in.
+    ///
+    /// This must be called before any chunk is requested or saved.
+    void setDirectory(const std::string &directory);
+
+    /// @brief Determines if a directory has been set.
+    bool isEnabled(void);
+
+    /// @brief Queues a chunk to be read.
+    ///
+    /// @returns True if the chunk was queued, or false if it was already
+    /// pending. A pending prefetch is promoted by a demanded request.
+    bool request(glm::ivec3 coords, bool prefetch);
+
+    /// @brief Drops the prefetches that have not started.
+    void clearPrefetches(void);
+
+    /// @brief Queues the blocks of a chunk to be written.
+    ///
+    /// The blocks are encoded before this returns, so it must be called on
+    /// the main thread.
+    void save(glm::ivec3 coords, const BlockStore &blocks);
+
+    /// @brief Retrieves a finished read.
+    ///
+    /// @returns True if a result was moved into result, or false if no reads
+    /// have finished.
+    bool collect(LoadResultStruct &result);
+
+    /// @brief Returns the buffers of a collected result to the loader.
+    void recycle(LoadResultStruct &result);
+
+    /// @brief Gets the number of demanded reads that have not finished.
+    unsigned int getPendingReads(void);
+
+    /// @brief Gets the number of bytes held by the queued writes, the
+    /// uncollected results and the spare buffers.
+    ///
+    /// The buffers of the job that is being processed are not included.
+    size_t getMemoryUsage(void);
+
+    /// @brief Waits until the loader thread is idle.
+    ///
+    /// The prefetches that have not started are dropped, and every queued
+    /// write and demanded read is finished.
+    void flush(void);
+
+    /// @brief Prints the number of chunks read, prefetched and written.
+    ///
+    /// This should only be called while the loader thread is idle.
+    void printStatistics(void);
+
+private:
+    /// @brief An enum representing the kinds of jobs in the job queue.
+    enum JobTypeEnum
+    {
+        READ = 0,
+        WRITE
+    };
+
+    /// @brief An enum representing the state of a pending read.
+    ///
+    /// A read is queued until the loader thread starts it, and is demanded
+    /// unless it is only a prefetch.
+    enum PendingStateEnum
+    {
+        QUEUED_PREFETCH = 0,
+        QUEUED_READ,
+        READING_PREFETCH,
+        READING
+    };
+
+    /// @brief A struct containing a job waiting for the loader thread.
+    ///
+    /// The payload is only used by writes.
+    struct LoadJobStruct
+    {
+        glm::ivec3 coords;
+        JobTypeEnum type;
+        std::vector<uint8_t> payload;
+    };
+
+    /// @brief The loader thread.
+    std::thread mThread;
+
+    /// @brief A flag indicating a directory has been set.
+    ///
+    /// This is only read on the main thread.
+    bool mEnabled;
+
+    /// @brief The storage used by the loader thread.
+    ChunkStorage mStorage;
+
+    /// @brief The mutex protecting all of the members below.
+    std::mutex mMutex;
+
+    /// @brief Signals the loader thread that a job is available or to stop.
+    std::condition_variable mJobAvailable;
+
+    /// @brief Signals the main thread that the loader thread is idle.
+    std::condition_variable mIdle;
+
+    /// @brief The queue of writes and demanded reads.
+    std::deque<LoadJobStruct> mJobs;
+
+    /// @brief The queue of prefetched reads.
+    std::deque<glm::ivec3> mPrefetches;
+
+    /// @brief The state of the pending read of each chunk.
+    CoordinateMap<PendingStateEnum> mPending;
+
+    /// @brief The number of pending reads that have been demanded.
+    unsigned int mPendingReads;
+
+    /// @brief The queue of finished reads waiting to be collected.
+    std::deque<LoadResultStruct> mResults;
+
+    /// @brief Buffers that are free to be reused by new results.
+    std::vector<std::vector<BlockId>> mFreeBlocks;
+
+    /// @brief A flag indicating the loader thread is processing a job.
+    bool mBusy;
+
+    /// @brief A flag telling the loader thread to exit.
+    bool mStopping;
+
+    /// @brief The number of reads and prefetches that have finished.
+    unsigned long mReads;
+    unsigned long mPrefetchReads;
+
+    /// @brief The main loop of the loader thread.
+    void work(void);
+};
+
+#endif
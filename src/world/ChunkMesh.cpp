@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkMesh.cpp
+/// @brief A mesh on the GPU shared between chunks.
+///
+/// This file contains the ChunkMesh class. Chunks whose blocks and neighbors
+/// are identical produce identical meshes, so they share a single ChunkMesh
+/// instead of each uploading their own copy.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <functional>
+
+#include "ChunkMesh.hpp"
+#include "ChunkVertex.hpp"
+#include "QuadIndexBuffer.hpp"
+
+std::unordered_multimap<size_t, ChunkMesh::MeshEntryStruct>
+    ChunkMesh::mMeshes;
+std::vector<ChunkMesh::BufferPairStruct> ChunkMesh::mFreeBuffers;
+size_t ChunkMesh::mTotalMemoryUsage = 0;
+
+bool ChunkMesh::ChunkMeshKeyStruct::operator==(
+    const ChunkMeshKeyStruct &other) const
+{
+    if ((mode != other.mode) || (blocks != other.blocks) ||
+        (lod != other.lod))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+        if ((neighbors[i] != other.neighbors[i]) ||
+            (neighborLods[i] != other.neighborLods[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ChunkMesh::ChunkMesh(const ChunkMeshKeyStruct &key, size_t hash)
+    : mKey(key), mHash(hash)
+{
+    mVao = 0;
+    mVbo = 0;
+    mVertices = 0;
+    mBytes = 0;
+}
+
+ChunkMesh::~ChunkMesh(void)
+{
+    if (mVao != 0)
+    {
+        glDeleteVertexArrays(1, &mVao);
+    }
+
+    if (mVbo != 0)
+    {
+        glDeleteBuffers(1, &mVbo);
+        mTotalMemoryUsage -= mBytes;
+    }
+}
+
+std::shared_ptr<ChunkMesh> ChunkMesh::find(const ChunkMeshKeyStruct &key)
+{
+    auto range = mMeshes.equal_range(hashKey(key));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.mesh->mKey == key)
+        {
+            return it->second.reference.lock();
+        }
+    }
+
+    return std::shared_ptr<ChunkMesh>();
+}
+
+std::shared_ptr<ChunkMesh> ChunkMesh::create(const ChunkMeshKeyStruct &key,
+    const std::vector<uint32_t> &vertices)
+{
+    size_t hash = hashKey(key);
+    std::shared_ptr<ChunkMesh> mesh(new ChunkMesh(key, hash),
+        &ChunkMesh::release);
+    mMeshes.insert({hash, MeshEntryStruct{mesh.get(), mesh}});
+
+    mesh->mVertices = vertices.size() / ChunkVertex::WORDS;
+    if (mesh->mVertices == 0)
+    {
+        return mesh;
+    }
+
+    if (!mFreeBuffers.empty())
+    {
+        // Reuse the objects of a released mesh, which are already set up.
+        mesh->mVao = mFreeBuffers.back().vao;
+        mesh->mVbo = mFreeBuffers.back().vbo;
+        mTotalMemoryUsage -= mFreeBuffers.back().bytes;
+        mFreeBuffers.pop_back();
+
+        glBindVertexArray(mesh->mVao);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->mVbo);
+    }
+    else
+    {
+        glGenVertexArrays(1, &mesh->mVao);
+        glBindVertexArray(mesh->mVao);
+
+        // The packed vertices are read as integers by the vertex shader.
+        glGenBuffers(1, &mesh->mVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->mVbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribIPointer(0, ChunkVertex::WORDS, GL_UNSIGNED_INT, 0, 0);
+    }
+
+    // Make sure the shared index buffer is large enough to draw the mesh.
+    QuadIndexBuffer::reserve(
+        mesh->mVertices / QuadIndexBuffer::VERTICES_PER_QUAD);
+
+    mesh->mBytes = vertices.size() * sizeof(uint32_t);
+    mTotalMemoryUsage += mesh->mBytes;
+    glBufferData(GL_ARRAY_BUFFER, mesh->mBytes, vertices.data(),
+        GL_STATIC_DRAW);
+
+    return mesh;
+}
+
+void ChunkMesh::render(void)
+{
+    if (mVertices == 0)
+    {
+        return;
+    }
+
+    int quads = mVertices / QuadIndexBuffer::VERTICES_PER_QUAD;
+
+    glBindVertexArray(mVao);
+    glDrawElements(GL_TRIANGLES, quads * QuadIndexBuffer::INDICES_PER_QUAD,
+        GL_UNSIGNED_INT, 0);
+}
+
+int ChunkMesh::getVertexCount(void)
+{
+    return mVertices;
+}
+
+size_t ChunkMesh::getMemoryUsage(void)
+{
+    return mBytes;
+}
+
+unsigned int ChunkMesh::getMeshCount(void)
+{
+    return mMeshes.size();
+}
+
+size_t ChunkMesh::getTotalMemoryUsage(void)
+{
+    return mTotalMemoryUsage;
+}
+
+void ChunkMesh::deleteFreeBuffers(void)
+{
+    for (BufferPairStruct &buffers : mFreeBuffers)
+    {
+        glDeleteVertexArrays(1, &buffers.vao);
+        glDeleteBuffers(1, &buffers.vbo);
+        mTotalMemoryUsage -= buffers.bytes;
+    }
+    mFreeBuffers.clear();
+}
+
+void ChunkMesh::release(ChunkMesh *mesh)
+{
+    auto range = mMeshes.equal_range(mesh->mHash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.mesh == mesh)
+        {
+            mMeshes.erase(it);
+            break;
+        }
+    }
+
+    // Keep the OpenGL objects for the next mesh. The destructor only deletes
+    // the objects that are not kept.
+    if ((mesh->mVao != 0) && (mFreeBuffers.size() < MAX_FREE_BUFFERS))
+    {
+        mFreeBuffers.push_back(
+            BufferPairStruct{mesh->mVao, mesh->mVbo, mesh->mBytes});
+        mesh->mVao = 0;
+        mesh->mVbo = 0;
+    }
+
+    delete mesh;
+}
+
+size_t ChunkMesh::hashKey(const ChunkMeshKeyStruct &key)
+{
+    // Block stores are content addressed, so their addresses identify their
+    // contents.
+    std::hash<const BlockStore *> hasher;
+    std::hash<int> levelHasher;
+    size_t h = std::hash<int>()(key.mode);
+    h ^= hasher(key.blocks.get()) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= levelHasher(key.lod) + 0x9e3779b9 + (h << 6) + (h >> 2);
+
+    for (int i = 0; i < 6; i++)
+    {
+        h ^= hasher(key.neighbors[i].get()) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= levelHasher(key.neighborLods[i]) + 0x9e3779b9 + (h << 6) +
+            (h >> 2);
+    }
+
+    return h;
+}
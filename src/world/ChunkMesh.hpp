@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkMesh.hpp
+/// @brief A mesh on the GPU shared between chunks.
+///
+/// This file contains the ChunkMesh class. Chunks whose blocks and neighbors
+/// are identical produce identical meshes, so they share a single ChunkMesh
+/// instead of each uploading their own copy.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHUNK_MESH_H_
+#define _CAMBRE_CHUNK_MESH_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "BlockStore.hpp"
+
+/// @class ChunkMesh
+/// @brief A mesh on the GPU shared between chunks.
+///
+/// A mesh is identified by the inputs it was generated from: the meshing mode,
+/// the BlockStore of the chunk and the BlockStores of its six neighbors, along
+/// with the level of detail that each of them is drawn at. Since block stores
+/// are content addressed, two chunks with the same key always produce the same
+/// mesh, and the mesh can be shared without being generated again. Meshes are
+/// reference counted. When the last chunk releases a mesh, its OpenGL objects
+/// are kept for the next mesh rather than deleted, so streaming chunks does not
+/// create and delete buffers every frame.
+///
+/// Meshes are only created and released on the thread that owns the OpenGL
+/// context.
+class ChunkMesh
+{
+public:
+    /// @brief A struct containing the inputs that a mesh was generated from.
+    ///
+    /// The neighbors are indexed by Chunk::ChunkDirectionEnum, and are null
+    /// when a neighbor is not loaded. The key holds references to the block
+    /// stores, so their addresses cannot be reused while the key is alive.
+    /// The levels of detail are 0 for chunks of a single type, which look the
+    /// same at every level.
+    struct ChunkMeshKeyStruct
+    {
+        int mode;
+        std::shared_ptr<const BlockStore> blocks;
+        std::shared_ptr<const BlockStore> neighbors[6];
+        int lod;
+        int neighborLods[6];
+
+        bool operator==(const ChunkMeshKeyStruct &other) const;
+    };
+
+    /// @brief The default destructor.
+    ///
+    /// Deletes the OpenGL objects of the mesh.
+    ~ChunkMesh(void);
+
+    /// @brief Finds a live mesh generated from a key.
+    ///
+    /// @returns The mesh, or null if no chunk is using a mesh with the key.
+    static std::shared_ptr<ChunkMesh> find(const ChunkMeshKeyStruct &key);
+
+    /// @brief Uploads a mesh generated from a key.
+    ///
+    /// The vertices are packed as described by ChunkVertex, with
+    /// ChunkVertex::WORDS words per vertex. Empty meshes do not create any
+    /// OpenGL objects.
+    static std::shared_ptr<ChunkMesh> create(const ChunkMeshKeyStruct &key,
+        const std::vector<uint32_t> &vertices);
+
+    /// @brief Draws the mesh.
+    void render(void);
+
+    /// @brief Gets the number of vertices in the mesh.
+    int getVertexCount(void);
+
+    /// @brief Gets the number of bytes in the mesh's vertex buffer.
+    size_t getMemoryUsage(void);
+
+    /// @brief Gets the number of distinct meshes that are alive.
+    static unsigned int getMeshCount(void);
+
+    /// @brief Gets the number of bytes in the vertex buffers of the live
+    /// meshes and of the buffers kept for reuse.
+    static size_t getTotalMemoryUsage(void);
+
+    /// @brief Deletes the buffers kept for reuse.
+    ///
+    /// This frees the video memory of the meshes that were released.
+    static void deleteFreeBuffers(void);
+
+private:
+    /// @brief A struct containing an entry of the mesh table.
+    ///
+    /// The raw pointer identifies the entry when its mesh is released, at
+    /// which point the weak reference has already expired.
+    struct MeshEntryStruct
+    {
+        const ChunkMesh *mesh;
+        std::weak_ptr<ChunkMesh> reference;
+    };
+
+    ChunkMesh(const ChunkMeshKeyStruct &key, size_t hash);
+
+    /// @brief Deletes a mesh and removes it from the mesh table.
+    static void release(ChunkMesh *mesh);
+
+    /// @brief Hashes the addresses of the block stores in a key.
+    static size_t hashKey(const ChunkMeshKeyStruct &key);
+
+    /// @brief The key that the mesh was generated from.
+    ChunkMeshKeyStruct mKey;
+
+    /// @brief The hash of the key.
+    size_t mHash;
+
+    /// @brief The OpenGL Vertex Array Object
+    GLuint mVao;
+
+    /// @brief The OpenGL Vertex Buffer Object
+    GLuint mVbo;
+
+    /// @brief The number of vertices in the VBO.
+    ///
+    /// Every four vertices form a quad drawn through the shared
+    /// QuadIndexBuffer.
+    int mVertices;
+
+    /// @brief The number of bytes in the VBO.
+    size_t mBytes;
+
+    /// @brief The live meshes, keyed by the hash of their key.
+    static std::unordered_multimap<size_t, MeshEntryStruct> mMeshes;
+
+    /// @brief A struct containing the OpenGL objects of a released mesh.
+    ///
+    /// The Vertex Array Object is already set up to read from the buffer.
+    ///
+    /// The buffer still holds the data of the released mesh until it is
+    /// reused, so its size is kept as well.
+    struct BufferPairStruct
+    {
+        GLuint vao;
+        GLuint vbo;
+        size_t bytes;
+    };
+
+    /// @brief The OpenGL objects waiting to be reused.
+    static std::vector<BufferPairStruct> mFreeBuffers;
+
+    /// @brief The maximum number of OpenGL objects kept for reuse.
+    static const unsigned int MAX_FREE_BUFFERS = 256;
+
+    /// @brief The number of bytes in the vertex buffers that exist.
+    static size_t mTotalMemoryUsage;
+};
+
+#endif
@@ -0,0 +1,664 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkMesher.cpp
+/// @brief A class to convert the blocks of a chunk into a mesh.
+///
+/// This file contains the ChunkMesher class. It generates the vertex data that
+/// the GPU uses to render a chunk, and it keeps statistics about the meshes it
+/// has generated so that different meshing algorithms can be compared.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "BitOps.hpp"
+#include "Block.hpp"
+#include "Chunk.hpp"
+#include "ChunkMesher.hpp"
+#include "ChunkVertex.hpp"
+#include "QuadIndexBuffer.hpp"
+
+static const char *MESHING_MODE_NAMES[ChunkMesher::MAX_MESHING_MODE] = {
+    "Naive",
+    "Greedy",
+    "Bitmask"
+};
+
+// The offsets of the neighboring block in each direction, indexed by
+// Chunk::ChunkDirectionEnum.
+static const int DIRECTION_OFFSET[6][3] = {
+    { 1,  0,  0},
+    {-1,  0,  0},
+    { 0,  1,  0},
+    { 0, -1,  0},
+    { 0,  0,  1},
+    { 0,  0, -1}
+};
+
+static constexpr int maxInt(int a, int b)
+{
+    return (a > b) ? a : b;
+}
+
+// The largest number of faces in a slice of the chunk.
+static const int MAX_SLICE_AREA = maxInt(
+    Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Y,
+    maxInt(Chunk::CHUNK_SIZE_Y * Chunk::CHUNK_SIZE_Z,
+        Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Z));
+
+ChunkMesher::ChunkMesher(void)
+{
+    mMode = GREEDY;
+    mCompareModes = false;
+    mVolume = nullptr;
+    mUniformType = -1;
+
+    for (int mode = 0; mode < MAX_MESHING_MODE; mode++)
+    {
+        mStatistics[mode] = {0, 0, 0.0};
+    }
+}
+
+void ChunkMesher::mesh(const BlockId *volume, std::vector<uint32_t> &out)
+{
+    // Every algorithm works on a copy of the blocks that includes the border
+    // of the neighboring chunks, so no neighbor lookups are needed while
+    // meshing.
+    mVolume = volume;
+    mUniformType = findUniformType();
+
+    // The faces between blocks of the same type are only hidden if the type
+    // is opaque or transparent, so other chunks are meshed in full.
+    if ((mUniformType >= 0) && !Block::isOpaque(mUniformType) &&
+        !Block::isTransparent(mUniformType) &&
+        (Block::getShape(mUniformType) == Block::SHAPE_CUBE))
+    {
+        mUniformType = -1;
+    }
+
+    meshWithMode(mMode, out);
+
+    if (mCompareModes)
+    {
+        for (int mode = 0; mode < MAX_MESHING_MODE; mode++)
+        {
+            if (mode != mMode)
+            {
+                meshWithMode(static_cast<MeshingModeEnum>(mode),
+                    mCompareData);
+            }
+        }
+    }
+
+    mVolume = nullptr;
+}
+
+void ChunkMesher::setMode(MeshingModeEnum mode)
+{
+    mMode = mode;
+}
+
+ChunkMesher::MeshingModeEnum ChunkMesher::getMode(void)
+{
+    return mMode;
+}
+
+void ChunkMesher::setCompareModes(bool enable)
+{
+    mCompareModes = enable;
+
+    // Release the comparison buffer when it is no longer needed.
+    if (!enable)
+    {
+        std::vector<uint32_t>().swap(mCompareData);
+    }
+}
+
+ChunkMesher::MeshStatisticsStruct ChunkMesher::getStatistics(
+    MeshingModeEnum mode)
+{
+    return mStatistics[mode];
+}
+
+void ChunkMesher::printStatistics(
+    const MeshStatisticsStruct statistics[MAX_MESHING_MODE])
+{
+    for (int mode = 0; mode < MAX_MESHING_MODE; mode++)
+    {
+        const MeshStatisticsStruct &stats = statistics[mode];
+        if (stats.chunks == 0)
+        {
+            continue;
+        }
+
+        std::cout << MESHING_MODE_NAMES[mode] << " Meshing: "
+            << stats.chunks << " chunks, "
+            << stats.vertices << " vertices ("
+            << stats.vertices / stats.chunks << " per chunk), "
+            << stats.seconds * 1000.0 << " ms ("
+            << stats.seconds * 1000000.0 / stats.chunks << " us per chunk)"
+            << std::endl;
+    }
+}
+
+void ChunkMesher::meshWithMode(MeshingModeEnum mode,
+    std::vector<uint32_t> &out)
+{
+    // The output is cleared rather than released, so its capacity is recycled
+    // from one chunk to the next.
+    out.clear();
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    if (mUniformType >= 0)
+    {
+        meshUniform(mode, out);
+    }
+    else
+    {
+        switch (mode)
+        {
+            case NAIVE: meshNaive(out); break;
+            case GREEDY: meshGreedy(out); break;
+            case BITMASK: meshBitmask(out); break;
+            default: break;
+        }
+    }
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    mStatistics[mode].chunks++;
+    mStatistics[mode].vertices += out.size() / ChunkVertex::WORDS;
+    mStatistics[mode].seconds += elapsed.count();
+}
+
+void ChunkMesher::meshNaive(std::vector<uint32_t> &out)
+{
+    int neighborOffset[6];
+    for (int dir = 0; dir < 6; dir++)
+    {
+        neighborOffset[dir] = Chunk::volumeIndex(DIRECTION_OFFSET[dir][0],
+            DIRECTION_OFFSET[dir][1], DIRECTION_OFFSET[dir][2]) -
+            Chunk::volumeIndex(0, 0, 0);
+    }
+
+    for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++)
+    {
+        for (int y = 0; y < Chunk::CHUNK_SIZE_Y; y++)
+        {
+            for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++)
+            {
+                int index = Chunk::volumeIndex(x, y, z);
+                BlockId type = mVolume[index];
+
+                // Do not add vertices for blocks that are not cubes.
+                if (Block::getShape(type) != Block::SHAPE_CUBE)
+                {
+                    continue;
+                }
+
+                // Add the quad of each visible face to the mesh data.
+                for (int dir = 0; dir < 6; dir++)
+                {
+                    if (Block::isFaceVisible(type,
+                        mVolume[index + neighborOffset[dir]]))
+                    {
+                        emitFace(out, glm::ivec3(x, y, z), dir, type);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ChunkMesher::meshGreedy(std::vector<uint32_t> &out)
+{
+    // Sweep over each axis in both directions. The directions are visited in
+    // the same order as Chunk::ChunkDirectionEnum.
+    const glm::ivec3 size = Chunk::getChunkSize();
+    for (int dir = 0; dir < 6; dir++)
+    {
+        for (int slice = 0; slice < size[dir / 2]; slice++)
+        {
+            meshGreedySlice(out, dir, slice);
+        }
+    }
+}
+
+void ChunkMesher::meshGreedySlice(std::vector<uint32_t> &out, int direction,
+    int slice)
+{
+    BlockId mask[MAX_SLICE_AREA];
+
+    // The slice is perpendicular to the axis d, and spanned by the u and v
+    // axes.
+    int d = direction / 2;
+    int u = (d + 1) % 3;
+    int v = (d + 2) % 3;
+    int negative = direction % 2;
+
+    const glm::ivec3 size = Chunk::getChunkSize();
+    const int width = size[u];
+    const int height = size[v];
+
+    const int *step = DIRECTION_OFFSET[direction];
+    int stepOffset = Chunk::volumeIndex(step[0], step[1], step[2]) -
+        Chunk::volumeIndex(0, 0, 0);
+
+    // Build the mask of the visible faces in this slice. Each entry holds the
+    // type of the face, or 0 if there is none.
+    glm::ivec3 p(0);
+    p[d] = slice;
+    int n = 0;
+    for (p[v] = 0; p[v] < height; p[v]++)
+    {
+        for (p[u] = 0; p[u] < width; p[u]++)
+        {
+            int index = Chunk::volumeIndex(p.x, p.y, p.z);
+            BlockId type = mVolume[index];
+
+            mask[n++] = Block::isFaceVisible(type, mVolume[index + stepOffset])
+                ? type : 0;
+        }
+    }
+
+    // Merge the faces in the mask into rectangles. Each rectangle is grown as
+    // wide as possible along u, then as tall as possible along v.
+    n = 0;
+    for (int j = 0; j < height; j++)
+    {
+        for (int k = 0; k < width; )
+        {
+            BlockId type = mask[n];
+            if (type == 0)
+            {
+                k++;
+                n++;
+                continue;
+            }
+
+            int w = 1;
+            while ((k + w < width) && (mask[n + w] == type))
+            {
+                w++;
+            }
+
+            int h = 1;
+            bool done = false;
+            while ((j + h < height) && !done)
+            {
+                for (int l = 0; l < w; l++)
+                {
+                    if (mask[n + l + h * width] != type)
+                    {
+                        done = true;
+                        break;
+                    }
+                }
+
+                if (!done)
+                {
+                    h++;
+                }
+            }
+
+            // Emit the rectangle, then clear it from the mask.
+            glm::ivec3 corner(0);
+            corner[d] = negative ? slice : slice + 1;
+            corner[u] = k;
+            corner[v] = j;
+
+            glm::ivec3 du(0);
+            du[u] = w;
+            glm::ivec3 dv(0);
+            dv[v] = h;
+
+            emitQuad(out, corner, du, dv, direction, type);
+
+            for (int row = 0; row < h; row++)
+            {
+                for (int l = 0; l < w; l++)
+                {
+                    mask[n + l + row * width] = 0;
+                }
+            }
+
+            k += w;
+            n += w;
+        }
+    }
+}
+
+void ChunkMesher::meshUniform(MeshingModeEnum mode,
+    std::vector<uint32_t> &out)
+{
+    // A chunk of blocks that are not cubes has no faces.
+    if (Block::getShape(mUniformType) != Block::SHAPE_CUBE)
+    {
+        return;
+    }
+
+    // Inside the chunk every face is hidden, so only the outermost slice in
+    // each direction can have faces, where the neighbor does not hide them.
+    const glm::ivec3 size = Chunk::getChunkSize();
+    for (int dir = 0; dir < 6; dir++)
+    {
+        int d = dir / 2;
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        int negative = dir % 2;
+        int slice = negative ? 0 : size[d] - 1;
+
+        if (mode == GREEDY)
+        {
+            meshGreedySlice(out, dir, slice);
+            continue;
+        }
+
+        glm::ivec3 p(0);
+        p[d] = slice;
+        for (p[v] = 0; p[v] < size[v]; p[v]++)
+        {
+            for (p[u] = 0; p[u] < size[u]; p[u]++)
+            {
+                glm::ivec3 n = p + glm::ivec3(DIRECTION_OFFSET[dir][0],
+                    DIRECTION_OFFSET[dir][1], DIRECTION_OFFSET[dir][2]);
+
+                if (Block::isFaceVisible(mUniformType,
+                    mVolume[Chunk::volumeIndex(n.x, n.y, n.z)]))
+                {
+                    emitFace(out, p, dir, mUniformType);
+                }
+            }
+        }
+    }
+}
+
+int ChunkMesher::findUniformType(void)
+{
+    // Compare every row of the chunk against its first row, which must itself
+    // hold a single type.
+    const BlockId *first = &mVolume[Chunk::volumeIndex(0, 0, 0)];
+    for (int z = 1; z < Chunk::CHUNK_SIZE_Z; z++)
+    {
+        if (first[z] != first[0])
+        {
+            return -1;
+        }
+    }
+
+    for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++)
+    {
+        for (int y = 0; y < Chunk::CHUNK_SIZE_Y; y++)
+        {
+            if (std::memcmp(&mVolume[Chunk::volumeIndex(x, y, 0)], first,
+                Chunk::CHUNK_SIZE_Z * sizeof(BlockId)) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    return first[0];
+}
+
+void ChunkMesher::meshBitmask(std::vector<uint32_t> &out)
+{
+    // The bitmask kernel stores two rows of the volume along z per (x, y)
+    // pair. Bit i of the cube row is set when block i - 1 of the row is a cube,
+    // and bit i of the opaque row is set when it is opaque, so the border
+    // blocks occupy bit 0 and bit CHUNK_SIZE_Z + 1.
+    const int padY = Chunk::VOLUME_SIZE_Y;
+    const int padZ = Chunk::VOLUME_SIZE_Z;
+    const BitmaskRow interior =
+        ((static_cast<BitmaskRow>(1) << Chunk::CHUNK_SIZE_Z) - 1) << 1;
+
+    // Build the rows. With SSE2, 16 blocks are compared against zero at once
+    // and their results are packed into bytes and gathered into a mask. Only
+    // the blocks that are not empty need their properties looked up.
+    static_assert(sizeof(BlockId) == 2,
+        "The bitmask mesher compares 16-bit blocks");
+
+    for (int r = 0; r < ROW_COUNT; r++)
+    {
+        const BlockId *blocks = &mVolume[r * padZ];
+        BitmaskRow row = 0;
+        int z = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i zero = _mm_setzero_si128();
+        for (; z + 16 <= padZ; z += 16)
+        {
+            __m128i lo = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(blocks + z));
+            __m128i hi = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(blocks + z + 8));
+            __m128i empty = _mm_packs_epi16(_mm_cmpeq_epi16(lo, zero),
+                _mm_cmpeq_epi16(hi, zero));
+            row |= static_cast<BitmaskRow>(
+                ~_mm_movemask_epi8(empty) & 0xFFFF) << z;
+        }
+#endif
+
+        for (; z < padZ; z++)
+        {
+            row |= static_cast<BitmaskRow>(blocks[z] != 0) << z;
+        }
+
+        BitmaskRow cubes = 0;
+        BitmaskRow opaque = 0;
+        while (row != 0)
+        {
+            z = countTrailingZeros(row);
+            row &= row - 1;
+
+            cubes |= static_cast<BitmaskRow>(
+                Block::getShape(blocks[z]) == Block::SHAPE_CUBE) << z;
+            opaque |= static_cast<BitmaskRow>(Block::isOpaque(blocks[z])) << z;
+        }
+
+        mRows[r] = cubes;
+        mOpaqueRows[r] = opaque;
+    }
+
+    // Find the exposed faces. A face of a cube in the y and x directions is
+    // exposed when the neighboring opaque row, one or padY rows away, is clear
+    // at the same bit; in the z direction the cube row is compared against the
+    // opaque row shifted by one bit.
+    // Only rows with an x inside the chunk are processed; the y border rows
+    // are skipped when the faces are extracted.
+    const int begin = padY;
+    const int end = padY * (Chunk::CHUNK_SIZE_X + 1);
+    const bool wide = sizeof(BitmaskRow) == sizeof(uint64_t);
+
+#if defined(__AVX2__)
+    const int width = 32 / sizeof(BitmaskRow);
+#elif defined(__SSE2__) || defined(_M_X64)
+    const int width = 16 / sizeof(BitmaskRow);
+#else
+    const int width = 1;
+#endif
+    const int vectorEnd = end - ((end - begin) % width);
+
+#if defined(__AVX2__)
+    const __m256i interiorMask = wide
+        ? _mm256_set1_epi64x(static_cast<int64_t>(interior))
+        : _mm256_set1_epi32(static_cast<int32_t>(interior));
+    for (int r = begin; r < vectorEnd; r += width)
+    {
+        __m256i c = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(&mRows[r]));
+        __m256i px = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(&mOpaqueRows[r + padY]));
+        __m256i nx = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(&mOpaqueRows[r - padY]));
+        __m256i py = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(&mOpaqueRows[r + 1]));
+        __m256i ny = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(&mOpaqueRows[r - 1]));
+        __m256i o = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(&mOpaqueRows[r]));
+        __m256i pz = wide ? _mm256_srli_epi64(o, 1) : _mm256_srli_epi32(o, 1);
+        __m256i nz = wide ? _mm256_slli_epi64(o, 1) : _mm256_slli_epi32(o, 1);
+
+        c = _mm256_and_si256(c, interiorMask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&mFaces[Chunk::pX][r]),
+            _mm256_andnot_si256(px, c));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&mFaces[Chunk::nX][r]),
+            _mm256_andnot_si256(nx, c));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&mFaces[Chunk::pY][r]),
+            _mm256_andnot_si256(py, c));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&mFaces[Chunk::nY][r]),
+            _mm256_andnot_si256(ny, c));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&mFaces[Chunk::pZ][r]),
+            _mm256_andnot_si256(pz, c));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&mFaces[Chunk::nZ][r]),
+            _mm256_andnot_si256(nz, c));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128i interiorMask = wide
+        ? _mm_set1_epi64x(static_cast<int64_t>(interior))
+        : _mm_set1_epi32(static_cast<int32_t>(interior));
+    for (int r = begin; r < vectorEnd; r += width)
+    {
+        __m128i c = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&mRows[r]));
+        __m128i px = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&mOpaqueRows[r + padY]));
+        __m128i nx = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&mOpaqueRows[r - padY]));
+        __m128i py = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&mOpaqueRows[r + 1]));
+        __m128i ny = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&mOpaqueRows[r - 1]));
+        __m128i o = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&mOpaqueRows[r]));
+        __m128i pz = wide ? _mm_srli_epi64(o, 1) : _mm_srli_epi32(o, 1);
+        __m128i nz = wide ? _mm_slli_epi64(o, 1) : _mm_slli_epi32(o, 1);
+
+        c = _mm_and_si128(c, interiorMask);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&mFaces[Chunk::pX][r]),
+            _mm_andnot_si128(px, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&mFaces[Chunk::nX][r]),
+            _mm_andnot_si128(nx, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&mFaces[Chunk::pY][r]),
+            _mm_andnot_si128(py, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&mFaces[Chunk::nY][r]),
+            _mm_andnot_si128(ny, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&mFaces[Chunk::pZ][r]),
+            _mm_andnot_si128(pz, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&mFaces[Chunk::nZ][r]),
+            _mm_andnot_si128(nz, c));
+    }
+#else
+    (void)wide;
+#endif
+
+    // Any rows that do not fill a whole vector are processed one at a time.
+    for (int r = (width > 1) ? vectorEnd : begin; r < end; r++)
+    {
+        BitmaskRow c = mRows[r] & interior;
+
+        mFaces[Chunk::pX][r] = c & ~mOpaqueRows[r + padY];
+        mFaces[Chunk::nX][r] = c & ~mOpaqueRows[r - padY];
+        mFaces[Chunk::pY][r] = c & ~mOpaqueRows[r + 1];
+        mFaces[Chunk::nY][r] = c & ~mOpaqueRows[r - 1];
+        mFaces[Chunk::pZ][r] = c & ~(mOpaqueRows[r] >> 1);
+        mFaces[Chunk::nZ][r] = c & ~(mOpaqueRows[r] << 1);
+    }
+
+    // Count the faces so the output only needs to grow once.
+    int faces = 0;
+    for (int dir = 0; dir < 6; dir++)
+    {
+        for (int x = 1; x <= Chunk::CHUNK_SIZE_X; x++)
+        {
+            for (int y = 1; y <= Chunk::CHUNK_SIZE_Y; y++)
+            {
+                faces += popCount(mFaces[dir][(x * padY) + y]);
+            }
+        }
+    }
+    out.reserve(faces * QuadIndexBuffer::VERTICES_PER_QUAD *
+        ChunkVertex::WORDS);
+
+    // Emit a quad for each set bit. The faces between two blocks of the same
+    // transparent type are not exposed, but they cannot be told apart with the
+    // rows alone, so they are checked here.
+    for (int dir = 0; dir < 6; dir++)
+    {
+        int neighborOffset = Chunk::volumeIndex(DIRECTION_OFFSET[dir][0],
+            DIRECTION_OFFSET[dir][1], DIRECTION_OFFSET[dir][2]) -
+            Chunk::volumeIndex(0, 0, 0);
+
+        for (int x = 1; x <= Chunk::CHUNK_SIZE_X; x++)
+        {
+            for (int y = 1; y <= Chunk::CHUNK_SIZE_Y; y++)
+            {
+                int row = (x * padY) + y;
+                BitmaskRow bits = mFaces[dir][row];
+
+                while (bits != 0)
+                {
+                    int z = countTrailingZeros(bits);
+                    bits &= bits - 1;
+
+                    int index = (row * padZ) + z;
+                    BlockId type = mVolume[index];
+                    if (Block::isTransparent(type) &&
+                        (mVolume[index + neighborOffset] == type))
+                    {
+                        continue;
+                    }
+
+                    emitFace(out, glm::ivec3(x - 1, y - 1, z - 1), dir, type);
+                }
+            }
+        }
+    }
+}
+
+void ChunkMesher::emitFace(std::vector<uint32_t> &out, glm::ivec3 block,
+    int direction, BlockId type)
+{
+    // Each face is a unit quad in the plane perpendicular to its direction.
+    // Faces along the positive axis sit on the far side of the block.
+    int d = direction / 2;
+    int u = (d + 1) % 3;
+    int v = (d + 2) % 3;
+
+    glm::ivec3 corner = block;
+    if ((direction % 2) == 0)
+    {
+        corner[d] += 1;
+    }
+
+    glm::ivec3 du(0);
+    du[u] = 1;
+    glm::ivec3 dv(0);
+    dv[v] = 1;
+
+    emitQuad(out, corner, du, dv, direction, type);
+}
+
+void ChunkMesher::emitQuad(std::vector<uint32_t> &out, glm::ivec3 corner,
+    glm::ivec3 du, glm::ivec3 dv, int direction, BlockId type)
+{
+    // The corners are ordered so that every face is wound consistently when
+    // viewed from outside of the block. The shared QuadIndexBuffer turns them
+    // into the triangles (0, 1, 2) and (0, 2, 3).
+    bool negative = (direction % 2) != 0;
+
+    ChunkVertex::append(out, corner, direction, type);
+    ChunkVertex::append(out, corner + (negative ? dv : du), direction, type);
+    ChunkVertex::append(out, corner + du + dv, direction, type);
+    ChunkVertex::append(out, corner + (negative ? du : dv), direction, type);
+}
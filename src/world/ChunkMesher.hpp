@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkMesher.hpp
+/// @brief A class to convert the blocks of a chunk into a mesh.
+///
+/// This file contains the ChunkMesher class. It generates the vertex data that
+/// the GPU uses to render a chunk, and it keeps statistics about the meshes it
+/// has generated so that different meshing algorithms can be compared.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHUNK_MESHER_H_
+#define _CAMBRE_CHUNK_MESHER_H_
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "Chunk.hpp"
+
+/// @class ChunkMesher
+/// @brief A class to convert the blocks of a chunk into a mesh.
+///
+/// The ChunkMesher turns the blocks of a chunk into quads. Faces are culled
+/// with Block::isFaceVisible, so faces hidden by an opaque block or shared by
+/// two blocks of the same transparent type are never emitted. The meshing mode
+/// selects how the remaining faces are turned into triangles.
+class ChunkMesher
+{
+public:
+    /// @brief An enum representing the available meshing algorithms.
+    ///
+    /// The naive mode emits a quad for every visible face of every block. The
+    /// greedy mode merges coplanar faces of the same type into maximal
+    /// rectangles before emitting them. The bitmask mode emits the same faces
+    /// as the naive mode, but finds them with bitwise operations on rows of
+    /// blocks instead of testing each block.
+    enum MeshingModeEnum
+    {
+        NAIVE = 0,
+        GREEDY,
+        BITMASK,
+        MAX_MESHING_MODE
+    };
+
+    /// @brief A struct containing the statistics of a meshing mode.
+    ///
+    /// These statistics are accumulated each time a chunk is meshed.
+    struct MeshStatisticsStruct
+    {
+        unsigned long chunks;
+        unsigned long vertices;
+        double seconds;
+    };
+
+    /// @brief The default constructor.
+    ///
+    /// Constructs a mesher that uses greedy meshing.
+    ChunkMesher(void);
+
+    /// @brief Generates the mesh for a chunk.
+    ///
+    /// This function generates the packed vertices of a chunk using the
+    /// current meshing mode. The volume must be filled by Chunk::gatherVolume.
+    /// Every four vertices of the output form a quad. The output is cleared
+    /// first, so its capacity is reused when the same vector is passed again.
+    ///
+    /// The mesher does not touch the chunk itself, so a mesher can run on any
+    /// thread as long as each thread uses its own mesher.
+    void mesh(const BlockId *volume, std::vector<uint32_t> &out);
+
+    /// @brief Sets the meshing mode.
+    ///
+    /// This function sets the algorithm used by subsequent calls to mesh.
+    void setMode(MeshingModeEnum mode);
+
+    /// @brief Gets the meshing mode.
+    MeshingModeEnum getMode(void);
+
+    /// @brief Enables the comparison of meshing modes.
+    ///
+    /// When enabled, every chunk is additionally meshed with each of the other
+    /// modes so that their vertex counts and meshing times can be compared.
+    /// The extra meshes are discarded.
+    void setCompareModes(bool enable);
+
+    /// @brief Gets the statistics for a meshing mode.
+    MeshStatisticsStruct getStatistics(MeshingModeEnum mode);
+
+    /// @brief Prints the statistics of every meshing mode that has been used.
+    ///
+    /// The statistics array is indexed by MeshingModeEnum, which allows the
+    /// statistics of several meshers to be combined before printing.
+    static void printStatistics(
+        const MeshStatisticsStruct statistics[MAX_MESHING_MODE]);
+
+private:
+    /// @brief The algorithm used to mesh chunks.
+    MeshingModeEnum mMode;
+
+    /// @brief A flag indicating all modes should be measured.
+    bool mCompareModes;
+
+    /// @brief The statistics of each meshing mode.
+    MeshStatisticsStruct mStatistics[MAX_MESHING_MODE];
+
+    /// @brief A scratch buffer to hold the meshes generated for comparison.
+    std::vector<uint32_t> mCompareData;
+
+    /// @brief The blocks of the chunk being meshed, including its border.
+    const BlockId *mVolume;
+
+    /// @brief The type of every block of the chunk being meshed, or -1 if
+    /// the chunk has more than one type.
+    int mUniformType;
+
+    /// @brief A row of bits used by the bitmask mesher.
+    ///
+    /// A row holds one bit per block of the volume along z, so it widens to
+    /// 64 bits for chunks that are more than 30 blocks long in z.
+    typedef std::conditional<(Chunk::VOLUME_SIZE_Z <= 32), uint32_t,
+        uint64_t>::type BitmaskRow;
+
+    static_assert(Chunk::VOLUME_SIZE_Z <= 64,
+        "The bitmask mesher requires a row to fit in 64 bits");
+
+    /// @brief The number of rows in the volume, one for each (x, y) pair.
+    static const int ROW_COUNT = Chunk::VOLUME_SIZE_X * Chunk::VOLUME_SIZE_Y;
+
+    /// @brief The occupancy rows used by the bitmask mesher.
+    ///
+    /// Each row holds one bit per block along z for an (x, y) pair of the
+    /// volume. mRows marks the cubes, which have faces, and mOpaqueRows marks
+    /// the opaque blocks, which hide faces.
+    BitmaskRow mRows[ROW_COUNT];
+    BitmaskRow mOpaqueRows[ROW_COUNT];
+
+    /// @brief The exposed faces found by the bitmask mesher.
+    ///
+    /// Each row holds one bit per face along z for an (x, y) pair of the
+    /// volume, indexed by Chunk::ChunkDirectionEnum.
+    BitmaskRow mFaces[6][ROW_COUNT];
+
+    /// @brief Meshes the volume with a specific mode and records the
+    /// statistics.
+    void meshWithMode(MeshingModeEnum mode, std::vector<uint32_t> &out);
+
+    /// @brief The naive meshing algorithm.
+    ///
+    /// This function emits one quad for each visible face of each block.
+    void meshNaive(std::vector<uint32_t> &out);
+
+    /// @brief The greedy meshing algorithm.
+    ///
+    /// This function sweeps each axis slice by slice, building a mask of the
+    /// visible faces in the slice and merging faces of the same type into
+    /// rectangles.
+    /// https://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
+    void meshGreedy(std::vector<uint32_t> &out);
+
+    /// @brief Merges the visible faces of one slice in one direction.
+    void meshGreedySlice(std::vector<uint32_t> &out, int direction,
+        int slice);
+
+    /// @brief The meshing algorithm for chunks of a single type.
+    ///
+    /// This function only visits the outermost slice of the chunk in each
+    /// direction, since every other face of a solid chunk is hidden. The faces
+    /// are merged in the greedy mode and emitted one by one otherwise.
+    void meshUniform(MeshingModeEnum mode, std::vector<uint32_t> &out);
+
+    /// @brief Finds the type of a chunk of a single type.
+    ///
+    /// @returns The type of every block in the chunk, or -1 if the chunk has
+    /// more than one type.
+    int findUniformType(void);
+
+    /// @brief The bitmask meshing algorithm.
+    ///
+    /// This function packs the volume into rows of occupancy bits and finds
+    /// the exposed faces of a whole row of blocks at once with shifts and
+    /// masks. Rows of 32 bits are processed with SSE2 or AVX2 when available.
+    void meshBitmask(std::vector<uint32_t> &out);
+
+    /// @brief Appends the quad of a single block face to the output.
+    static void emitFace(std::vector<uint32_t> &out, glm::ivec3 block,
+        int direction, BlockId type);
+
+    /// @brief Appends the four vertices of a quad to the output.
+    ///
+    /// The quad starts at the corner and spans du and dv. The winding is
+    /// reversed for faces that point along the negative axis. The vertices are
+    /// appended as described by ChunkVertex.
+    static void emitQuad(std::vector<uint32_t> &out, glm::ivec3 corner,
+        glm::ivec3 du, glm::ivec3 dv, int direction, BlockId type);
+};
+
+#endif
@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkScheduler.cpp
+/// @brief A priority queue of chunks waiting to be loaded or unloaded.
+///
+/// This file contains the ChunkScheduler class. It orders pending chunk
+/// requests by their distance to the camera and by whether the camera can see
+/// them, so that the terrain in front of the camera is loaded first.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "Chunk.hpp"
+#include "ChunkScheduler.hpp"
+
+ChunkScheduler::ChunkScheduler(ScheduleOrderEnum order)
+{
+    mOrder = order;
+    mPosition = glm::vec3(0.0f);
+    mFacing = glm::vec3(0.0f, 0.0f, -1.0f);
+    mOrderedPosition = mPosition;
+    mOrderedFacing = mFacing;
+    mReorder = false;
+
+    // Until a view is set, every chunk is considered visible.
+    for (int i = 0; i < 6; i++)
+    {
+        mPlanes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+void ChunkScheduler::setView(glm::vec3 position, glm::vec3 facing,
+    const glm::mat4 &viewProjection)
+{
+    mPosition = position;
+    mFacing = facing;
+
+    // Extract the frustum planes from the rows of the matrix, as described by
+    // Gribb and Hartmann.
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i],
+            viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        mPlanes[(2 * i)] = rows[3] + rows[i];
+        mPlanes[(2 * i) + 1] = rows[3] - rows[i];
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+        mPlanes[i] /= glm::length(glm::vec3(mPlanes[i]));
+    }
+
+    // Only reorder the heap once the camera has moved or turned enough to
+    // change the order of the chunks.
+    float chunkLength = glm::length(glm::vec3(Chunk::getChunkSize()));
+    if ((glm::distance(mPosition, mOrderedPosition) >
+            REPRIORITIZE_DISTANCE * chunkLength) ||
+        (glm::dot(mFacing, mOrderedFacing) < REPRIORITIZE_FACING))
+    {
+        mReorder = true;
+    }
+}
+
+bool ChunkScheduler::push(glm::ivec3 coords)
+{
+    if (!mPending.insert(coords, 1))
+    {
+        return false;
+    }
+
+    mRequests.push_back(RequestStruct{coords, prioritize(coords)});
+    std::push_heap(mRequests.begin(), mRequests.end(), compare);
+
+    return true;
+}
+
+bool ChunkScheduler::pop(glm::ivec3 &coords)
+{
+    if (mRequests.empty())
+    {
+        return false;
+    }
+
+    if (mReorder)
+    {
+        for (RequestStruct &request : mRequests)
+        {
+            request.key = prioritize(request.coords);
+        }
+
+        std::make_heap(mRequests.begin(), mRequests.end(), compare);
+        mOrderedPosition = mPosition;
+        mOrderedFacing = mFacing;
+        mReorder = false;
+    }
+
+    std::pop_heap(mRequests.begin(), mRequests.end(), compare);
+    coords = mRequests.back().coords;
+    mRequests.pop_back();
+    mPending.erase(coords);
+
+    return true;
+}
+
+unsigned int ChunkScheduler::size(void) const
+{
+    return mRequests.size();
+}
+
+float ChunkScheduler::prioritize(glm::ivec3 coords) const
+{
+    glm::vec3 center = Chunk::chunkCenterToWorldCoords(coords);
+    float distance = glm::distance(mPosition, center);
+
+    // Chunks out of view are treated as farther away in both orders, so they
+    // are loaded last and unloaded first.
+    if (!isVisible(center))
+    {
+        distance *= OUT_OF_VIEW_PENALTY;
+    }
+
+    return (mOrder == FARTHEST_FIRST) ? -distance : distance;
+}
+
+bool ChunkScheduler::isVisible(glm::vec3 center) const
+{
+    // Test the bounding sphere of the chunk against each plane.
+    float radius = 0.5f * glm::length(glm::vec3(Chunk::getChunkSize()));
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (glm::dot(glm::vec3(mPlanes[i]), center) + mPlanes[i].w < -radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkScheduler.hpp
+/// @brief A priority queue of chunks waiting to be loaded or unloaded.
+///
+/// This file contains the ChunkScheduler class. It orders pending chunk
+/// requests by their distance to the camera and by whether the camera can see
+/// them, so that the terrain in front of the camera is loaded first.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHUNK_SCHEDULER_H_
+#define _CAMBRE_CHUNK_SCHEDULER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "CoordinateMap.hpp"
+
+/// @class ChunkScheduler
+/// @brief A priority queue of chunks waiting to be loaded or unloaded.
+///
+/// Each chunk is pending at most once, no matter how many times it is pushed.
+/// The priority of a chunk is its distance from the camera, and chunks outside
+/// of the view frustum are treated as OUT_OF_VIEW_PENALTY times farther away
+/// than they are, so a chunk next to the camera still beats a distant one in
+/// view. The priorities are recomputed when the camera moves or turns far
+/// enough to change the order.
+class ChunkScheduler
+{
+public:
+    /// @brief An enum representing the order that chunks are popped in.
+    enum ScheduleOrderEnum
+    {
+        NEAREST_FIRST = 0,
+        FARTHEST_FIRST
+    };
+
+    /// @brief The factor applied to the distance of chunks out of view.
+    static constexpr float OUT_OF_VIEW_PENALTY = 4.0f;
+
+    /// @brief The distance the camera moves before the priorities are
+    /// recomputed, in chunks.
+    static constexpr float REPRIORITIZE_DISTANCE = 0.5f;
+
+    /// @brief The cosine of the angle the camera turns before the priorities
+    /// are recomputed.
+    static constexpr float REPRIORITIZE_FACING = 0.985f;
+
+    ChunkScheduler(ScheduleOrderEnum order);
+
+    /// @brief Sets the camera used to prioritize the chunks.
+    ///
+    /// The view frustum is extracted from the view-projection matrix.
+    void setView(glm::vec3 position, glm::vec3 facing,
+        const glm::mat4 &viewProjection);
+
+    /// @brief Adds a chunk to the queue.
+    ///
+    /// @returns True if the chunk was added, or false if it is already
+    /// pending.
+    bool push(glm::ivec3 coords);
+
+    /// @brief Takes the chunk with the highest priority from the queue.
+    ///
+    /// @returns False if no chunks are pending.
+    bool pop(glm::ivec3 &coords);
+
+    /// @brief Gets the number of pending chunks.
+    unsigned int size(void) const;
+
+    /// @brief Computes the key of a chunk for the current view.
+    ///
+    /// Chunks with lower keys are popped first. The chunk does not need to be
+    /// pending.
+    float prioritize(glm::ivec3 coords) const;
+
+private:
+    /// @brief A struct containing a pending chunk.
+    ///
+    /// Requests with a lower key are popped first.
+    struct RequestStruct
+    {
+        glm::ivec3 coords;
+        float key;
+    };
+
+    /// @brief Orders the heap so that the lowest key is on top.
+    static bool compare(const RequestStruct &a, const RequestStruct &b)
+    {
+        return a.key > b.key;
+    }
+
+    /// @brief Tests whether a chunk intersects the view frustum.
+    bool isVisible(glm::vec3 center) const;
+
+    /// @brief The order that chunks are popped in.
+    ScheduleOrderEnum mOrder;
+
+    /// @brief The pending chunks, kept as a binary heap.
+    std::vector<RequestStruct> mRequests;
+
+    /// @brief The set of pending chunks, used to drop duplicate requests.
+    CoordinateMap<uint8_t> mPending;
+
+    /// @brief The camera position and facing.
+    glm::vec3 mPosition;
+    glm::vec3 mFacing;
+
+    /// @brief The planes of the view frustum, facing inwards.
+    glm::vec4 mPlanes[6];
+
+    /// @brief The camera position and facing that the heap is ordered for.
+    glm::vec3 mOrderedPosition;
+    glm::vec3 mOrderedFacing;
+
+    /// @brief A flag indicating the heap needs to be reordered.
+    bool mReorder;
+};
+
+#endif
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkStorage.cpp
+/// @brief The saved chunks of a world.
+///
+/// This file contains the ChunkStorage class. It keeps the region files of a
+/// save directory open while they are in use, and routes the loads and saves
+/// of each chunk to the file of its region.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "ChunkStorage.hpp"
+
+ChunkStorage::ChunkStorage(void)
+{
+    mUseCounter = 0;
+    mLoads = 0;
+    mMisses = 0;
+    mSaves = 0;
+}
+
+void ChunkStorage::setDirectory(const std::string &directory)
+{
+    mFiles.clear();
+    mDirectory = directory;
+
+    if (mDirectory.empty())
+    {
+        return;
+    }
+
+    // The directory may already exist, in which case this fails harmlessly.
+#if defined(_WIN32)
+    _mkdir(mDirectory.c_str());
+#else
+    mkdir(mDirectory.c_str(), 0755);
+#endif
+}
+
+bool ChunkStorage::isEnabled(void)
+{
+    return !mDirectory.empty();
+}
+
+bool ChunkStorage::load(glm::ivec3 coords, BlockId *blocks, bool &uniform)
+{
+    RegionFile *file = getFile(RegionFile::chunkToRegionCoords(coords));
+    if ((file == nullptr) ||
+        !file->load(RegionFile::chunkToLocalCoords(coords), blocks, uniform))
+    {
+        mMisses++;
+        return false;
+    }
+
+    mLoads++;
+
+    return true;
+}
+
+bool ChunkStorage::save(glm::ivec3 coords,
+    const std::vector<uint8_t> &payload)
+{
+    RegionFile *file = getFile(RegionFile::chunkToRegionCoords(coords));
+    if ((file == nullptr) ||
+        !file->save(RegionFile::chunkToLocalCoords(coords), payload))
+    {
+        return false;
+    }
+
+    mSaves++;
+
+    return true;
+}
+
+void ChunkStorage::printStatistics(void)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    std::cout << "Storage: " << mLoads << " chunks read, " << mMisses
+        << " chunks not saved, " << mSaves << " chunks written" << std::endl;
+}
+
+RegionFile *ChunkStorage::getFile(glm::ivec3 region)
+{
+    if (!isEnabled())
+    {
+        return nullptr;
+    }
+
+    mUseCounter++;
+
+    unsigned int oldest = 0;
+    for (unsigned int i = 0; i < mFiles.size(); i++)
+    {
+        if (mFiles[i].region == region)
+        {
+            mFiles[i].lastUsed = mUseCounter;
+            return mFiles[i].file->isOpen() ? mFiles[i].file.get() : nullptr;
+        }
+
+        if (mFiles[i].lastUsed < mFiles[oldest].lastUsed)
+        {
+            oldest = i;
+        }
+    }
+
+    std::ostringstream path;
+    path << mDirectory << "/r." << region.x << "." << region.y << "."
+        << region.z << ".cmr";
+
+    OpenFileStruct entry{region,
+        std::make_shared<RegionFile>(path.str()), mUseCounter};
+
+    // Files that could not be opened stay in the list, so that the error is
+    // only reported once.
+    if (mFiles.size() < MAX_OPEN_FILES)
+    {
+        mFiles.push_back(entry);
+    }
+    else
+    {
+        mFiles[oldest] = entry;
+    }
+
+    return entry.file->isOpen() ? entry.file.get() : nullptr;
+}
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkStorage.hpp
+/// @brief The saved chunks of a world.
+///
+/// This file contains the ChunkStorage class. It keeps the region files of a
+/// save directory open while they are in use, and routes the loads and saves
+/// of each chunk to the file of its region.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHUNK_STORAGE_H_
+#define _CAMBRE_CHUNK_STORAGE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Block.hpp"
+#include "RegionFile.hpp"
+
+/// @class ChunkStorage
+/// @brief The saved chunks of a world.
+///
+/// Chunks are saved in the RegionFile of their region, named after the
+/// coordinates of the region. At most MAX_OPEN_FILES files are kept open, and
+/// the least recently used file is closed to make room for another. Storage is
+/// disabled until a directory is set, in which case every load misses and
+/// every save is dropped.
+///
+/// The storage does not touch any shared state, so it can be used on a
+/// background thread, as long as one thread uses it at a time.
+class ChunkStorage
+{
+public:
+    /// @brief The maximum number of region files kept open.
+    static const unsigned int MAX_OPEN_FILES = 16;
+
+    ChunkStorage(void);
+
+    /// @brief Sets the directory that the region files are kept in.
+    ///
+    /// The directory is created if it does not exist. An empty path disables
+    /// storage.
+    void setDirectory(const std::string &directory);
+
+    /// @brief Determines if a directory has been set.
+    bool isEnabled(void);
+
+    /// @brief Reads the saved blocks of a chunk.
+    ///
+    /// The blocks are decoded as described by RegionFile::decode.
+    ///
+    /// @returns False if the chunk has not been saved.
+    bool load(glm::ivec3 coords, BlockId *blocks, bool &uniform);
+
+    /// @brief Saves the payload of a chunk made by RegionFile::encode.
+    ///
+    /// @returns True if the chunk was written.
+    bool save(glm::ivec3 coords, const std::vector<uint8_t> &payload);
+
+    /// @brief Prints the number of chunks read and written.
+    void printStatistics(void);
+
+private:
+    /// @brief A struct containing an open region file.
+    struct OpenFileStruct
+    {
+        glm::ivec3 region;
+        std::shared_ptr<RegionFile> file;
+        unsigned long lastUsed;
+    };
+
+    /// @brief Gets the open file of a region, opening it if necessary.
+    RegionFile *getFile(glm::ivec3 region);
+
+    /// @brief The directory holding the region files.
+    std::string mDirectory;
+
+    /// @brief The open region files.
+    ///
+    /// There are only a few, so they are searched in order.
+    std::vector<OpenFileStruct> mFiles;
+
+    /// @brief A counter used to find the least recently used file.
+    unsigned long mUseCounter;
+
+    /// @brief The number of chunks read, missed and written.
+    unsigned long mLoads;
+    unsigned long mMisses;
+    unsigned long mSaves;
+};
+
+#endif
@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file ChunkVertex.hpp
+/// @brief The packed vertex format used by chunk meshes.
+///
+/// This file contains the ChunkVertex class. Each vertex of a chunk mesh is
+/// packed into one or two 32-bit integers, which are decoded by the chunk
+/// vertex shader.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_CHUNK_VERTEX_H_
+#define _CAMBRE_CHUNK_VERTEX_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BitOps.hpp"
+#include "Chunk.hpp"
+
+/// @class ChunkVertex
+/// @brief The packed vertex format used by chunk meshes.
+///
+/// A vertex holds the following fields, from the least significant bit:
+/// - The x, y, and z positions local to the chunk. Each position uses just
+///   enough bits to hold the size of the chunk along its axis, since a vertex
+///   may sit on the far side of the last block.
+/// - 3 bits for the face normal, a Chunk::ChunkDirectionEnum value.
+/// - 14 bits for the block type.
+///
+/// If every field fits in 32 bits, which is the case for 16^3 chunks, a
+/// vertex is a single word. Otherwise the positions are stored in the first
+/// word and the normal and type in a second word.
+///
+/// The layout must match the decoding in chunk.v.glsl.
+class ChunkVertex
+{
+public:
+    static const int POSITION_BITS_X = bitWidth(Chunk::CHUNK_SIZE_X);
+    static const int POSITION_BITS_Y = bitWidth(Chunk::CHUNK_SIZE_Y);
+    static const int POSITION_BITS_Z = bitWidth(Chunk::CHUNK_SIZE_Z);
+    static const int POSITION_BITS =
+        POSITION_BITS_X + POSITION_BITS_Y + POSITION_BITS_Z;
+    static const int NORMAL_BITS = 3;
+    static const int TYPE_BITS = 14;
+
+    /// @brief The number of 32-bit words in a vertex.
+    static const int WORDS =
+        ((POSITION_BITS + NORMAL_BITS + TYPE_BITS) <= 32) ? 1 : 2;
+
+    static_assert(POSITION_BITS < 32,
+        "The positions of a vertex must fit in one word");
+
+    /// @brief Appends the packed words of a vertex to a mesh.
+    static void append(std::vector<uint32_t> &out, glm::ivec3 position,
+        int normal, int type)
+    {
+        uint32_t positions = static_cast<uint32_t>(position.x) |
+            (static_cast<uint32_t>(position.y) << POSITION_BITS_X) |
+            (static_cast<uint32_t>(position.z) <<
+                (POSITION_BITS_X + POSITION_BITS_Y));
+        uint32_t attributes = static_cast<uint32_t>(normal) |
+            (static_cast<uint32_t>(type) << NORMAL_BITS);
+
+        if (WORDS == 1)
+        {
+            out.push_back(positions | (attributes << POSITION_BITS));
+        }
+        else
+        {
+            out.push_back(positions);
+            out.push_back(attributes);
+        }
+    }
+};
+
+#endif
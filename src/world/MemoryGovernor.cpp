@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file MemoryGovernor.cpp
+/// @brief A memory budget for the loaded chunks.
+///
+/// This file contains the MemoryGovernor class. It tracks the memory held by
+/// the loaded chunks and decides when the load distance has to shrink to stay
+/// within a budget, and when it can grow back.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "MemoryGovernor.hpp"
+
+MemoryGovernor::MemoryGovernor(void)
+{
+    mBudget = 0;
+    mPeak = 0;
+    mShrinks = 0;
+    mGrows = 0;
+    mMinDistance = 0;
+
+    for (int i = 0; i < MAX_MEMORY_CATEGORY; i++)
+    {
+        mUsage[i] = 0;
+        mPeakUsage[i] = 0;
+    }
+}
+
+void MemoryGovernor::setBudget(size_t bytes)
+{
+    mBudget = bytes;
+}
+
+bool MemoryGovernor::isEnabled(void)
+{
+    return mBudget != 0;
+}
+
+void MemoryGovernor::setUsage(MemoryCategoryEnum category, size_t bytes)
+{
+    mUsage[category] = bytes;
+
+    size_t total = getUsage();
+    if (total > mPeak)
+    {
+        mPeak = total;
+        for (int i = 0; i < MAX_MEMORY_CATEGORY; i++)
+        {
+            mPeakUsage[i] = mUsage[i];
+        }
+    }
+}
+
+size_t MemoryGovernor::getUsage(void)
+{
+    size_t total = 0;
+
+    for (int i = 0; i < MAX_MEMORY_CATEGORY; i++)
+    {
+        total += mUsage[i];
+    }
+
+    return total;
+}
+
+bool MemoryGovernor::isOverBudget(void)
+{
+    return isEnabled() && (getUsage() > mBudget);
+}
+
+bool MemoryGovernor::canGrow(double factor)
+{
+    return !isEnabled() ||
+        (static_cast<double>(getUsage()) * factor <
+            static_cast<double>(mBudget) * GROW_THRESHOLD);
+}
+
+void MemoryGovernor::recordDistance(unsigned int distance, bool shrunk)
+{
+    if (shrunk)
+    {
+        mShrinks++;
+    }
+    else
+    {
+        mGrows++;
+    }
+
+    if ((mMinDistance == 0) || (distance < mMinDistance))
+    {
+        mMinDistance = distance;
+    }
+}
+
+void MemoryGovernor::printStatistics(void)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    std::cout << "Memory: peak " << mPeak << " bytes of " << mBudget
+        << " (block stores " << mPeakUsage[BLOCK_STORES] << ", chunks "
+        << mPeakUsage[CHUNKS] << ", mesh buffers "
+        << mPeakUsage[MESH_BUFFERS] << "), distance shrank " << mShrinks
+        << " times to as little as " << mMinDistance << ", grew " << mGrows
+        << " times" << std::endl;
+}
@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file MemoryGovernor.hpp
+/// @brief A memory budget for the loaded chunks.
+///
+/// This file contains the MemoryGovernor class. It tracks the memory held by
+/// the loaded chunks and decides when the load distance has to shrink to stay
+/// within a budget, and when it can grow back.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_MEMORY_GOVERNOR_H_
+#define _CAMBRE_MEMORY_GOVERNOR_H_
+
+#include <cstddef>
+
+/// @class MemoryGovernor
+/// @brief A memory budget for the loaded chunks.
+///
+/// The owner measures the bytes held by each category once per tick. While
+/// the total is over the budget, the load distance should shrink; once the
+/// total would stay under GROW_THRESHOLD of the budget with a larger distance,
+/// it may grow again. The gap between the two keeps the distance from
+/// flipping back and forth. A budget of zero disables the governor.
+class MemoryGovernor
+{
+public:
+    /// @brief An enum representing the kinds of memory that are tracked.
+    ///
+    /// Block stores hold the blocks of the loaded, cached and resident chunks.
+    /// Chunks are the objects in the chunk pool, including its free slots,
+    /// and the buffers of the chunks being read or written by the loader. Mesh
+    /// buffers are the volumes and vertices held on the CPU by the mesh
+    /// workers.
+    enum MemoryCategoryEnum
+    {
+        BLOCK_STORES = 0,
+        CHUNKS,
+        MESH_BUFFERS,
+        MAX_MEMORY_CATEGORY
+    };
+
+    /// @brief The fraction of the budget that the usage must stay under for
+    /// the load distance to grow.
+    static constexpr double GROW_THRESHOLD = 0.75;
+
+    /// @brief The default constructor.
+    ///
+    /// The governor starts out disabled.
+    MemoryGovernor(void);
+
+    /// @brief Sets the number of bytes the chunks may use.
+    void setBudget(size_t bytes);
+
+    /// @brief Determines if a budget has been set.
+    bool isEnabled(void);
+
+    /// @brief Sets the number of bytes used by a category.
+    void setUsage(MemoryCategoryEnum category, size_t bytes);
+
+    /// @brief Gets the number of bytes used by every category.
+    size_t getUsage(void);
+
+    /// @brief Determines if the usage is over the budget.
+    bool isOverBudget(void);
+
+    /// @brief Determines if the usage can grow by a factor and stay under
+    /// GROW_THRESHOLD of the budget.
+    bool canGrow(double factor);
+
+    /// @brief Records that the load distance was changed.
+    void recordDistance(unsigned int distance, bool shrunk);
+
+    /// @brief Prints the peak usage and the changes to the load distance.
+    void printStatistics(void);
+
+private:
+    /// @brief The number of bytes the chunks may use.
+    size_t mBudget;
+
+    /// @brief The number of bytes used by each category.
+    size_t mUsage[MAX_MEMORY_CATEGORY];
+
+    /// @brief The number of bytes used by each category at the peak.
+    size_t mPeakUsage[MAX_MEMORY_CATEGORY];
+
+    /// @brief The largest total usage measured.
+    size_t mPeak;
+
+    /// @brief The number of times the load distance shrank and grew.
+    unsigned long mShrinks;
+    unsigned long mGrows;
+
+    /// @brief The smallest load distance used.
+    unsigned int mMinDistance;
+};
+
+#endif
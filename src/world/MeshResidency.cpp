@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file MeshResidency.cpp
+/// @brief A video memory budget for the chunk meshes.
+///
+/// This file contains the MeshResidency class. It decides which chunks keep
+/// their meshes in video memory when the meshes use more than a budget, and
+/// when evicted meshes can be restored.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+
+#include "MeshResidency.hpp"
+
+MeshResidency::MeshResidency(void)
+{
+    mBudget = 0;
+    mTicks = 0;
+    mPeak = 0;
+    mEvictions = 0;
+    mRestores = 0;
+    mResidentChunks = 0;
+    mEvictedChunks = 0;
+}
+
+void MeshResidency::setBudget(size_t bytes)
+{
+    mBudget = bytes;
+}
+
+bool MeshResidency::isEnabled(void)
+{
+    return mBudget != 0;
+}
+
+size_t MeshResidency::getBudget(void)
+{
+    return mBudget;
+}
+
+bool MeshResidency::update(size_t usage)
+{
+    if (usage > mPeak)
+    {
+        mPeak = usage;
+    }
+
+    if (!isEnabled() || (++mTicks < REASSESS_TICKS))
+    {
+        return false;
+    }
+    mTicks = 0;
+
+    return (usage > mBudget) || (mEvictedChunks > 0);
+}
+
+void MeshResidency::plan(size_t usage, std::vector<CandidateStruct> &candidates,
+    std::vector<glm::ivec3> &evict, std::vector<glm::ivec3> &restore)
+{
+    // Meshes are shared by identical chunks, so each one is counted once.
+    std::unordered_set<const ChunkMesh *> meshes;
+    size_t meshBytes = 0;
+    for (const CandidateStruct &c : candidates)
+    {
+        if ((c.mesh != nullptr) && meshes.insert(c.mesh).second)
+        {
+            meshBytes += c.bytes;
+        }
+    }
+    size_t averageBytes = meshes.empty() ? 0 : meshBytes / meshes.size();
+
+    // The buffers kept for reuse and the meshes held by unloaded chunks are
+    // not drawn by any candidate, but they still use the budget.
+    size_t total = (usage > meshBytes) ? usage - meshBytes : 0;
+    size_t restoreLimit = static_cast<size_t>(mBudget * RESTORE_THRESHOLD);
+    bool full = false;
+
+    meshes.clear();
+    mResidentChunks = 0;
+    mEvictedChunks = 0;
+    std::sort(candidates.begin(), candidates.end(), compare);
+
+    for (const CandidateStruct &c : candidates)
+    {
+        size_t bytes = averageBytes;
+        if (c.mesh != nullptr)
+        {
+            bytes = (meshes.count(c.mesh) != 0) ? 0 : c.bytes;
+        }
+
+        // Once a chunk does not fit, every chunk after it is evicted, so a
+        // chunk never keeps its mesh while a more important one has none.
+        size_t limit = c.evicted ? restoreLimit : mBudget;
+        if (full || (total + bytes > limit))
+        {
+            full = true;
+        }
+
+        if (full && (bytes != 0))
+        {
+            if (!c.evicted)
+            {
+                evict.push_back(c.coords);
+            }
+            mEvictedChunks++;
+            continue;
+        }
+
+        if (c.evicted)
+        {
+            restore.push_back(c.coords);
+        }
+        if (c.mesh != nullptr)
+        {
+            meshes.insert(c.mesh);
+        }
+        total += bytes;
+        mResidentChunks++;
+    }
+
+    mEvictions += evict.size();
+    mRestores += restore.size();
+}
+
+void MeshResidency::printStatistics(void)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    std::cout << "Residency: peak " << mPeak << " bytes of " << mBudget
+        << ", " << mEvictions << " meshes evicted, " << mRestores
+        << " restored, " << mResidentChunks << " chunks resident and "
+        << mEvictedChunks << " evicted at the last plan" << std::endl;
+}
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file MeshResidency.hpp
+/// @brief A video memory budget for the chunk meshes.
+///
+/// This file contains the MeshResidency class. It decides which chunks keep
+/// their meshes in video memory when the meshes use more than a budget, and
+/// when evicted meshes can be restored.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_MESH_RESIDENCY_H_
+#define _CAMBRE_MESH_RESIDENCY_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ChunkMesh.hpp"
+
+/// @class MeshResidency
+/// @brief A video memory budget for the chunk meshes.
+///
+/// The owner reports the bytes held by the vertex buffers once per tick, and
+/// every REASSESS_TICKS ticks it plans the residency of the chunks while the
+/// meshes are over the budget or some meshes are evicted. The plan keeps the
+/// meshes of the chunks with the highest priority until the budget is used up
+/// and evicts the rest. An evicted mesh is only restored if it fits under
+/// RESTORE_THRESHOLD of the budget, so that chunks at the edge of the budget
+/// are not evicted and restored over and over. A budget of zero disables the
+/// residency.
+class MeshResidency
+{
+public:
+    /// @brief A struct containing a chunk that may hold a mesh.
+    ///
+    /// Chunks with a lower priority key keep their meshes first. The mesh is
+    /// null if the chunk has been evicted or has not been meshed yet; the
+    /// meshes of those chunks are assumed to have the average size.
+    struct CandidateStruct
+    {
+        glm::ivec3 coords;
+        float priority;
+        const ChunkMesh *mesh;
+        size_t bytes;
+        bool evicted;
+    };
+
+    /// @brief The number of ticks between plans.
+    static const unsigned int REASSESS_TICKS = 30;
+
+    /// @brief The fraction of the budget that the meshes must stay under for
+    /// an evicted mesh to be restored.
+    static constexpr double RESTORE_THRESHOLD = 0.9;
+
+    /// @brief The default constructor.
+    ///
+    /// The residency starts out disabled.
+    MeshResidency(void);
+
+    /// @brief Sets the number of bytes the vertex buffers may use.
+    void setBudget(size_t bytes);
+
+    /// @brief Determines if a budget has been set.
+    bool isEnabled(void);
+
+    /// @brief Gets the number of bytes the vertex buffers may use.
+    size_t getBudget(void);
+
+    /// @brief Records the bytes used by the vertex buffers for this tick.
+    ///
+    /// @returns True if the residency should be planned this tick.
+    bool update(size_t usage);
+
+    /// @brief Plans which chunks keep their meshes.
+    ///
+    /// The usage is the number of bytes held by every vertex buffer, including
+    /// those not drawn by any candidate. The candidates are sorted by
+    /// priority. The chunks whose meshes should be evicted and restored are
+    /// added to evict and restore.
+    void plan(size_t usage, std::vector<CandidateStruct> &candidates,
+        std::vector<glm::ivec3> &evict, std::vector<glm::ivec3> &restore);
+
+    /// @brief Prints the peak usage and the number of meshes evicted and
+    /// restored.
+    void printStatistics(void);
+
+private:
+    /// @brief Orders the candidates so that the highest priority is first.
+    static bool compare(const CandidateStruct &a, const CandidateStruct &b)
+    {
+        return a.priority < b.priority;
+    }
+
+    /// @brief The number of bytes the vertex buffers may use.
+    size_t mBudget;
+
+    /// @brief The number of ticks since the last plan.
+    unsigned int mTicks;
+
+    /// @brief The largest usage measured.
+    size_t mPeak;
+
+    /// @brief The number of meshes evicted and restored.
+    unsigned long mEvictions;
+    unsigned long mRestores;
+
+    /// @brief The number of chunks that were resident and evicted after the
+    /// last plan.
+    unsigned int mResidentChunks;
+    unsigned int mEvictedChunks;
+};
+
+#endif
@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file MeshWorkerPool.cpp
+/// @brief Meshes chunks on the workers of a job system.
+///
+/// This file contains the MeshWorkerPool class. It moves chunk meshing off of
+/// the main thread so that a burst of newly loaded chunks does not stall the
+/// main loop. Only the upload of the finished meshes happens on the main
+/// thread.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MeshWorkerPool.hpp"
+
+// The number of spare buffers of each kind kept per worker. Buffers returned
+// beyond this are released.
+static const unsigned int FREE_BUFFERS_PER_WORKER = 2;
+
+MeshWorkerPool::MeshWorkerPool(JobSystem &jobs)
+    : mJobSystem(jobs)
+{
+    mWorkerCount = jobs.getWorkerCount();
+    mRunning = 0;
+    mMode = ChunkMesher::GREEDY;
+    mCompareModes = false;
+}
+
+MeshWorkerPool::~MeshWorkerPool(void)
+{
+    // The jobs that are still queued in the job system find no chunks and
+    // finish at once.
+    std::unique_lock<std::mutex> lock(mMutex);
+    mJobs.clear();
+    mIdle.wait(lock, [this] {
+        return mRunning == 0;
+    });
+}
+
+void MeshWorkerPool::submit(glm::ivec3 coords, Chunk &chunk)
+{
+    MeshJobStruct job;
+    job.coords = coords;
+    ChunkMesher::MeshingModeEnum mode;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mode = mMode;
+        if (!mFreeVolumes.empty())
+        {
+            job.volume = std::move(mFreeVolumes.back());
+            mFreeVolumes.pop_back();
+        }
+    }
+
+    // Capture the chunk outside of the lock; only the main thread touches the
+    // chunk.
+    job.volume.resize(Chunk::VOLUME_BLOCK_COUNT);
+    job.revision = chunk.beginMeshing(job.volume.data(), mode);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+        mRunning++;
+    }
+
+    mJobSystem.submit([this](void) {
+        meshNext();
+    });
+}
+
+bool MeshWorkerPool::collect(MeshResultStruct &result)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mResults.empty())
+    {
+        return false;
+    }
+
+    result = std::move(mResults.front());
+    mResults.pop_front();
+
+    return true;
+}
+
+void MeshWorkerPool::recycle(MeshResultStruct &result)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mFreeVertices.size() < mWorkerCount * FREE_BUFFERS_PER_WORKER)
+    {
+        mFreeVertices.push_back(std::move(result.vertices));
+    }
+
+    result.vertices = std::vector<uint32_t>();
+}
+
+void MeshWorkerPool::setMode(ChunkMesher::MeshingModeEnum mode)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMode = mode;
+}
+
+ChunkMesher::MeshingModeEnum MeshWorkerPool::getMode(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMode;
+}
+
+void MeshWorkerPool::setCompareModes(bool enable)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCompareModes = enable;
+}
+
+unsigned int MeshWorkerPool::getWorkerCount(void)
+{
+    return mWorkerCount;
+}
+
+unsigned int MeshWorkerPool::getPendingJobs(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mJobs.size();
+}
+
+unsigned int MeshWorkerPool::getPendingResults(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mResults.size();
+}
+
+size_t MeshWorkerPool::getMemoryUsage(void)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t bytes = 0;
+
+    for (const MeshJobStruct &job : mJobs)
+    {
+        bytes += job.volume.capacity() * sizeof(BlockId);
+    }
+
+    for (const MeshResultStruct &result : mResults)
+    {
+        bytes += result.vertices.capacity() * sizeof(uint32_t);
+    }
+
+    for (const std::vector<BlockId> &volume : mFreeVolumes)
+    {
+        bytes += volume.capacity() * sizeof(BlockId);
+    }
+
+    for (const std::vector<uint32_t> &vertices : mFreeVertices)
+    {
+        bytes += vertices.capacity() * sizeof(uint32_t);
+    }
+
+    return bytes;
+}
+
+void MeshWorkerPool::printStatistics(void)
+{
+    ChunkMesher::MeshStatisticsStruct total[ChunkMesher::MAX_MESHING_MODE];
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (int mode = 0; mode < ChunkMesher::MAX_MESHING_MODE; mode++)
+        {
+            total[mode] = {0, 0, 0.0};
+
+            for (unsigned int i = 0; i < mMeshers.size(); i++)
+            {
+                const ChunkMesher::MeshStatisticsStruct &stats =
+                    mStatistics[(i * ChunkMesher::MAX_MESHING_MODE) + mode];
+
+                total[mode].chunks += stats.chunks;
+                total[mode].vertices += stats.vertices;
+                total[mode].seconds += stats.seconds;
+            }
+        }
+    }
+
+    ChunkMesher::printStatistics(total);
+}
+
+void MeshWorkerPool::meshNext(void)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (!mJobs.empty())
+    {
+        MeshJobStruct job = std::move(mJobs.front());
+        mJobs.pop_front();
+
+        // Borrow a mesher, creating one when every mesher is in use.
+        unsigned int index;
+        if (mFreeMeshers.empty())
+        {
+            index = mMeshers.size();
+            mMeshers.push_back(
+                std::unique_ptr<ChunkMesher>(new ChunkMesher()));
+            mStatistics.resize(
+                mMeshers.size() * ChunkMesher::MAX_MESHING_MODE,
+                ChunkMesher::MeshStatisticsStruct{0, 0, 0.0});
+        }
+        else
+        {
+            index = mFreeMeshers.back();
+            mFreeMeshers.pop_back();
+        }
+        ChunkMesher &mesher = *mMeshers[index];
+
+        mesher.setMode(mMode);
+        mesher.setCompareModes(mCompareModes);
+
+        MeshResultStruct result;
+        result.coords = job.coords;
+        result.revision = job.revision;
+        if (!mFreeVertices.empty())
+        {
+            result.vertices = std::move(mFreeVertices.back());
+            mFreeVertices.pop_back();
+        }
+
+        // Mesh without holding the lock.
+        lock.unlock();
+        mesher.mesh(job.volume.data(), result.vertices);
+        lock.lock();
+
+        if (mFreeVolumes.size() < mWorkerCount * FREE_BUFFERS_PER_WORKER)
+        {
+            mFreeVolumes.push_back(std::move(job.volume));
+        }
+        mResults.push_back(std::move(result));
+
+        for (int mode = 0; mode < ChunkMesher::MAX_MESHING_MODE; mode++)
+        {
+            mStatistics[(index * ChunkMesher::MAX_MESHING_MODE) + mode] =
+                mesher.getStatistics(
+                    static_cast<ChunkMesher::MeshingModeEnum>(mode));
+        }
+        mFreeMeshers.push_back(index);
+    }
+
+    mRunning--;
+    if (mRunning == 0)
+    {
+        mIdle.notify_all();
+    }
+}
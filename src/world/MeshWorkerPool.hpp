@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file MeshWorkerPool.hpp
+/// @brief Meshes chunks on the workers of a job system.
+///
+/// This file contains the MeshWorkerPool class. It moves chunk meshing off of
+/// the main thread so that a burst of newly loaded chunks does not stall the
+/// main loop. Only the upload of the finished meshes happens on the main
+/// thread.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_MESH_WORKER_POOL_H_
+#define _CAMBRE_MESH_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Chunk.hpp"
+#include "ChunkMesher.hpp"
+#include "JobSystem.hpp"
+
+/// @class MeshWorkerPool
+/// @brief Meshes chunks on the workers of a job system.
+///
+/// The main thread captures a chunk's blocks with submit, and a job on one of
+/// the workers of the job system meshes the captured copy. Meshing shares the
+/// workers with the other jobs, such as generation, so the two do not compete
+/// for more threads than there are cores. Each job borrows a ChunkMesher, and
+/// its scratch buffers, from the pool. Finished meshes are handed back to the
+/// main thread through collect. Each result carries the revision of the chunk
+/// it was generated from, so Chunk::endMeshing can discard results for chunks
+/// that were edited in the meantime.
+class MeshWorkerPool
+{
+public:
+    /// @brief A struct containing a finished mesh.
+    struct MeshResultStruct
+    {
+        glm::ivec3 coords;
+        unsigned long revision;
+        std::vector<uint32_t> vertices;
+    };
+
+    /// @brief Creates a pool that meshes on the workers of a job system.
+    ///
+    /// The job system must outlive the pool.
+    MeshWorkerPool(JobSystem &jobs);
+
+    /// @brief The default destructor.
+    ///
+    /// Drops the chunks that have not started meshing, and waits for the
+    /// jobs that are meshing to finish.
+    ~MeshWorkerPool(void);
+
+    /// @brief Queues a chunk to be meshed.
+    ///
+    /// This function captures the chunk's blocks via Chunk::beginMeshing, so
+    /// it must be called on the main thread. The chunk itself is not touched
+    /// by the workers.
+    void submit(glm::ivec3 coords, Chunk &chunk);
+
+    /// @brief Retrieves a finished mesh.
+    ///
+    /// @returns True if a result was moved into result, or false if no meshes
+    /// have finished.
+    bool collect(MeshResultStruct &result);
+
+    /// @brief Returns the buffers of a collected result to the pool.
+    ///
+    /// This allows the vertex buffer to be reused by a later job once its
+    /// contents have been uploaded.
+    void recycle(MeshResultStruct &result);
+
+    /// @brief Sets the meshing mode used by the workers.
+    void setMode(ChunkMesher::MeshingModeEnum mode);
+
+    /// @brief Gets the meshing mode used by the workers.
+    ChunkMesher::MeshingModeEnum getMode(void);
+
+    /// @brief Enables the comparison of meshing modes in the workers.
+    void setCompareModes(bool enable);
+
+    /// @brief Gets the number of workers of the job system.
+    unsigned int getWorkerCount(void);
+
+    /// @brief Gets the number of jobs that have not been started.
+    unsigned int getPendingJobs(void);
+
+    /// @brief Gets the number of finished meshes that have not been collected.
+    unsigned int getPendingResults(void);
+
+    /// @brief Gets the number of bytes held by the queued jobs, the finished
+    /// meshes and the spare buffers.
+    ///
+    /// The buffers of the jobs that are being meshed are not included.
+    size_t getMemoryUsage(void);
+
+    /// @brief Prints the combined meshing statistics of all workers.
+    void printStatistics(void);
+
+private:
+    /// @brief A struct containing a chunk waiting to be meshed.
+    struct MeshJobStruct
+    {
+        glm::ivec3 coords;
+        unsigned long revision;
+        std::vector<BlockId> volume;
+    };
+
+    /// @brief The job system that runs the meshing jobs.
+    JobSystem &mJobSystem;
+
+    /// @brief The number of workers of the job system.
+    unsigned int mWorkerCount;
+
+    /// @brief The mutex protecting all of the members below.
+    std::mutex mMutex;
+
+    /// @brief Signals the destructor that no meshing jobs are running.
+    std::condition_variable mIdle;
+
+    /// @brief The number of meshing jobs submitted to the job system that
+    /// have not finished.
+    unsigned int mRunning;
+
+    /// @brief The queue of chunks waiting to be meshed.
+    ///
+    /// Each meshing job takes the oldest chunk, so chunks are meshed in the
+    /// order they are submitted.
+    std::deque<MeshJobStruct> mJobs;
+
+    /// @brief The queue of finished meshes waiting to be collected.
+    std::deque<MeshResultStruct> mResults;
+
+    /// @brief Buffers that are free to be reused by new jobs.
+    std::vector<std::vector<BlockId>> mFreeVolumes;
+    std::vector<std::vector<uint32_t>> mFreeVertices;
+
+    /// @brief The settings applied to each mesher.
+    ChunkMesher::MeshingModeEnum mMode;
+    bool mCompareModes;
+
+    /// @brief The meshers, which are created as the jobs need them.
+    std::vector<std::unique_ptr<ChunkMesher>> mMeshers;
+
+    /// @brief The indices of the meshers that are not in use.
+    std::vector<unsigned int> mFreeMeshers;
+
+    /// @brief The latest statistics of each mesher.
+    ///
+    /// The statistics of mesher i for mode m are stored at index
+    /// (i * MAX_MESHING_MODE) + m.
+    std::vector<ChunkMesher::MeshStatisticsStruct> mStatistics;
+
+    /// @brief Meshes the oldest queued chunk, if there is one.
+    ///
+    /// This is the work of each meshing job.
+    void meshNext(void);
+};
+
+#endif
@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file PaletteStorage.cpp
+/// @brief A compact array of blocks that stores indices into a palette.
+///
+/// This file contains the PaletteStorage class. Most chunks only contain a
+/// handful of block types, so each block is stored as a small index into a
+/// palette of the types that actually occur instead of as a full BlockId.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Hash.hpp"
+#include "PaletteStorage.hpp"
+
+// Gets the narrowest supported width that can index a palette.
+static unsigned int bitsForPalette(size_t entries)
+{
+    if (entries <= 1)
+    {
+        return 0;
+    }
+
+    unsigned int bits = 1;
+    while ((static_cast<size_t>(1) << bits) < entries)
+    {
+        bits *= 2;
+    }
+
+    return bits;
+}
+
+PaletteStorage::PaletteStorage(void)
+{
+    mSize = 0;
+    mBits = 0;
+    mPalette.push_back(0);
+    resize(0);
+}
+
+PaletteStorage::PaletteStorage(unsigned int size)
+{
+    mSize = size;
+    mBits = 0;
+    mPalette.push_back(0);
+    resize(0);
+}
+
+void PaletteStorage::assign(const BlockId *blocks, unsigned int size)
+{
+    // The blocks are a single row.
+    assignRows(size, size, [blocks](unsigned int) {
+        return blocks;
+    });
+}
+
+void PaletteStorage::pack(const std::vector<uint16_t> &indices)
+{
+    if (mPalette.empty())
+    {
+        mPalette.push_back(0);
+    }
+
+    resize(bitsForPalette(mPalette.size()));
+
+    if (mBits == 0)
+    {
+        return;
+    }
+
+    for (unsigned int i = 0; i < mSize; i++)
+    {
+        unsigned int shift = (i & mIndexMask) * mBits;
+        mWords[i >> mIndexShift] |= static_cast<uint64_t>(indices[i]) << shift;
+    }
+}
+
+void PaletteStorage::unpack(unsigned int begin, unsigned int count,
+    BlockId *out) const
+{
+    if (mBits == 0)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            out[i] = mPalette[0];
+        }
+
+        return;
+    }
+
+    // Decode each word once, shifting out one index at a time.
+    unsigned int i = 0;
+    while (i < count)
+    {
+        unsigned int index = begin + i;
+        unsigned int position = index & mIndexMask;
+        uint64_t word = mWords[index >> mIndexShift] >> (position * mBits);
+
+        for (; (position <= mIndexMask) && (i < count); position++, i++)
+        {
+            out[i] = mPalette[word & mValueMask];
+            word >>= mBits;
+        }
+    }
+}
+
+unsigned int PaletteStorage::getSize(void) const
+{
+    return mSize;
+}
+
+unsigned int PaletteStorage::getBitsPerBlock(void) const
+{
+    return mBits;
+}
+
+unsigned int PaletteStorage::getPaletteSize(void) const
+{
+    return mPalette.size();
+}
+
+size_t PaletteStorage::getMemoryUsage(void) const
+{
+    return (mPalette.capacity() * sizeof(BlockId)) +
+        (mWords.capacity() * sizeof(uint64_t));
+}
+
+uint64_t PaletteStorage::hash(void) const
+{
+    uint64_t h = hashBytes(mPalette.data(), mPalette.size() * sizeof(BlockId));
+    h ^= hashBytes(mWords.data(), mWords.size() * sizeof(uint64_t)) +
+        0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+
+    return h;
+}
+
+bool PaletteStorage::operator==(const PaletteStorage &other) const
+{
+    return (mSize == other.mSize) && (mPalette == other.mPalette) &&
+        (mWords == other.mWords);
+}
+
+unsigned int PaletteStorage::findOrAdd(BlockId id)
+{
+    for (unsigned int i = 0; i < mPalette.size(); i++)
+    {
+        if (mPalette[i] == id)
+        {
+            return i;
+        }
+    }
+
+    mPalette.push_back(id);
+    return mPalette.size() - 1;
+}
+
+void PaletteStorage::resize(unsigned int bits)
+{
+    std::vector<uint64_t> words;
+
+    if (bits > 0)
+    {
+        unsigned int perWord = 64 / bits;
+        unsigned int indexShift = 0;
+        while ((1u << indexShift) < perWord)
+        {
+            indexShift++;
+        }
+
+        words.resize((mSize + perWord - 1) / perWord, 0);
+
+        mIndexShift = indexShift;
+        mIndexMask = perWord - 1;
+        mValueMask = (1ULL << bits) - 1;
+    }
+    else
+    {
+        mIndexShift = 0;
+        mIndexMask = 0;
+        mValueMask = 0;
+    }
+
+    mWords.swap(words);
+    mBits = bits;
+}
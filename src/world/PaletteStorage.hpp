@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file PaletteStorage.hpp
+/// @brief A compact array of blocks that stores indices into a palette.
+///
+/// This file contains the PaletteStorage class. Most chunks only contain a
+/// handful of block types, so each block is stored as a small index into a
+/// palette of the types that actually occur instead of as a full BlockId.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_PALETTE_STORAGE_H_
+#define _CAMBRE_PALETTE_STORAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Block.hpp"
+
+/// @class PaletteStorage
+/// @brief A compact array of blocks that stores indices into a palette.
+///
+/// The storage holds a palette of distinct BlockIds and one index per block.
+/// The indices are packed into 64-bit words using 0, 1, 2, 4, 8 or 16 bits
+/// each; the width is a power of two so that an index never straddles two
+/// words. A chunk with two types uses 1 bit per block, and a chunk with up to
+/// sixteen types uses 4 bits per block.
+///
+/// The storage is only filled as a whole, since the block stores that hold it
+/// are never modified. assign builds the palette from scratch, and always
+/// produces the same palette and words for the same blocks, so two storages
+/// built by assign are equal exactly when their blocks are equal.
+class PaletteStorage
+{
+public:
+    /// @brief The default constructor.
+    ///
+    /// Constructs an empty storage.
+    PaletteStorage(void);
+
+    /// @brief Constructs a storage of empty blocks.
+    explicit PaletteStorage(unsigned int size);
+
+    /// @brief Replaces the contents of the storage with an array of blocks.
+    ///
+    /// The palette lists the types in the order that they first occur, and
+    /// the narrowest width that fits the palette is used.
+    void assign(const BlockId *blocks, unsigned int size);
+
+    /// @brief Replaces the contents of the storage with rows of blocks.
+    ///
+    /// The storage is filled in order from rows of rowLength blocks, and the
+    /// size must be a multiple of the row length. rowAt is called with the
+    /// index of the first block of each row and returns a pointer to the row,
+    /// which lets blocks be stored in another order than they are held in
+    /// without reordering them into a copy first. The result is the same as
+    /// assign with the rows laid end to end.
+    template <typename RowSource>
+    void assignRows(unsigned int size, unsigned int rowLength,
+        RowSource rowAt);
+
+    /// @brief Gets the block at an index.
+    BlockId get(unsigned int index) const
+    {
+        if (mBits == 0)
+        {
+            return mPalette[0];
+        }
+
+        uint64_t word = mWords[index >> mIndexShift];
+        unsigned int shift = (index & mIndexMask) * mBits;
+
+        return mPalette[(word >> shift) & mValueMask];
+    }
+
+    /// @brief Copies a range of blocks into an array.
+    ///
+    /// The blocks are decoded one word at a time, which is much faster than
+    /// calling get for each block.
+    void unpack(unsigned int begin, unsigned int count, BlockId *out) const;
+
+    /// @brief Gets the number of blocks in the storage.
+    unsigned int getSize(void) const;
+
+    /// @brief Gets the number of bits used for each block.
+    unsigned int getBitsPerBlock(void) const;
+
+    /// @brief Gets the number of types in the palette.
+    unsigned int getPaletteSize(void) const;
+
+    /// @brief Gets the number of bytes used by the palette and the indices.
+    size_t getMemoryUsage(void) const;
+
+    /// @brief Hashes the palette and the indices.
+    uint64_t hash(void) const;
+
+    bool operator==(const PaletteStorage &other) const;
+
+private:
+    /// @brief Finds the index of a type in the palette, adding it if needed.
+    ///
+    /// This does not widen the indices, so the caller must check that the
+    /// returned index fits.
+    unsigned int findOrAdd(BlockId id);
+
+    /// @brief Clears the indices and sets them to a new width.
+    void resize(unsigned int bits);
+
+    /// @brief Packs the palette index of every block with the narrowest
+    /// width that fits the palette.
+    void pack(const std::vector<uint16_t> &indices);
+
+    /// @brief The distinct types in the storage.
+    std::vector<BlockId> mPalette;
+
+    /// @brief The packed palette indices of the blocks.
+    std::vector<uint64_t> mWords;
+
+    /// @brief The number of blocks in the storage.
+    unsigned int mSize;
+
+    /// @brief The number of bits used for each index.
+    unsigned int mBits;
+
+    /// @brief The values used to locate an index within the words.
+    ///
+    /// A block's word is its index shifted right by mIndexShift, and its
+    /// position within the word is its index masked by mIndexMask. Each value
+    /// is masked by mValueMask.
+    unsigned int mIndexShift;
+    unsigned int mIndexMask;
+    uint64_t mValueMask;
+};
+
+template <typename RowSource>
+void PaletteStorage::assignRows(unsigned int size, unsigned int rowLength,
+    RowSource rowAt)
+{
+    mSize = size;
+    mPalette.clear();
+    mWords.clear();
+
+    // Build the palette first, so the width is known before any index is
+    // packed. Runs of the same type are common, so the previous type is
+    // checked before searching the palette.
+    std::vector<uint16_t> indices(size);
+    BlockId previous = 0;
+    unsigned int previousIndex = 0;
+    for (unsigned int start = 0; start < size; start += rowLength)
+    {
+        const BlockId *row = rowAt(start);
+        for (unsigned int i = 0; i < rowLength; i++)
+        {
+            if (((start + i) == 0) || (row[i] != previous))
+            {
+                previous = row[i];
+                previousIndex = findOrAdd(previous);
+            }
+
+            indices[start + i] = previousIndex;
+        }
+    }
+
+    pack(indices);
+}
+
+#endif
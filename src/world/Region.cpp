@@ -7,31 +7,137 @@
 /// as loading and unloading the chunks.
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "BlockStore.hpp"
+#include "ChunkMesh.hpp"
+#include "ChunkVertex.hpp"
 #include "Region.hpp"
+#include "TerrainGenerator.hpp"
 
-Region::Region(void)
+// The number of jobs queued per mesh worker before the region stops
+// capturing chunks. Captured volumes wait in memory until a worker is free, so
+// queueing more than the workers can keep up with only costs memory.
+static const unsigned int QUEUED_MESH_JOBS_PER_WORKER = 4;
+
+// The number of demanded reads the loader may have pending before the region
+// stops requesting chunks. Chunks are read nearest first, so a deep queue only
+// delays the chunks requested after the camera moves.
+static const unsigned int MAX_PENDING_READS = 256;
+
+// The number of chunks that may be generating at once before the region stops
+// requesting chunks. Like reads, generations are requested nearest first.
+static const unsigned int MAX_PENDING_GENERATIONS = 256;
+
+// The number of chunks that may be resident or generated without being loaded
+// before the chunks that are no longer expected are dropped.
+static const unsigned int MAX_RESIDENT_CHUNKS = 4096;
+
+// The number of ticks of movement that prefetches look ahead. At full speed
+// the camera crosses a few chunks in this time.
+static const float PREFETCH_TICKS = 120.0f;
+
+// The number of recently unloaded chunks kept to be revived.
+static const unsigned int CHUNK_CACHE_CAPACITY = 4096;
+
+// The number of chunk widths along the ground that the unload distance
+// extends past the load distance. Chunks between the two distances stay as
+// they are, so a camera moving back and forth across a chunk border does not
+// load and unload the same chunks.
+static const unsigned int UNLOAD_MARGIN_CHUNKS = 2;
+
+// The smallest load distance, in blocks, that the memory governor shrinks to.
+static const unsigned int MIN_CHUNK_DISTANCE = 64;
+
+// The number of chunk widths along the ground that a chunk must be past the
+// distance of a coarser level of detail before it moves to that level.
+static const unsigned int LOD_MARGIN_CHUNKS = 1;
+
+// The offset of the neighboring chunk in each direction, indexed by
+// Chunk::ChunkDirectionEnum.
+static const glm::ivec3 NEIGHBOR_OFFSETS[6] = {
+    glm::ivec3(1, 0, 0),
+    glm::ivec3(-1, 0, 0),
+    glm::ivec3(0, 1, 0),
+    glm::ivec3(0, -1, 0),
+    glm::ivec3(0, 0, 1),
+    glm::ivec3(0, 0, -1)
+};
+
+// Gets the length of a chunk along its shorter horizontal axis. Chunks may be
+// tall columns, and distances are covered along the ground, so the load
+// distance and its margins are measured in steps of this length.
+static unsigned int horizontalChunkSize(void)
 {
-    mChunkDistance = 256;
-    mChunkLoadRate = 10;
-    mChunkUnloadRate = 10;
+    glm::ivec3 size = Chunk::getChunkSize();
+    return std::min(size.x, size.z);
+}
 
-    mChunks.insert({glm::ivec3(0, 0, 0), new Chunk(0, 0, 0)});
+// Gets the direction opposite to a direction. The directions along each axis
+// are adjacent in Chunk::ChunkDirectionEnum.
+static Chunk::ChunkDirectionEnum oppositeDirection(int dir)
+{
+    return static_cast<Chunk::ChunkDirectionEnum>(dir ^ 1);
 }
 
-Region::~Region(void)
+// Gets the level of detail for a distance in blocks. Each level covers twice
+// the distance of the previous one.
+static int lodForDistance(double distance, unsigned int lodDistance)
 {
-    for (std::pair<glm::ivec3, Chunk *> p : mChunks)
+    int level = 0;
+    double limit = lodDistance;
+    while ((level < Chunk::LOD_LEVELS - 1) && (distance >= limit))
     {
-        if (p.second != nullptr)
-        {
-            delete p.second;
-        }
+        level++;
+        limit *= 2.0;
     }
+
+    return level;
+}
+
+// Gets the squared length of an offset in blocks. The products are widened
+// first so that distant coordinates do not overflow.
+static uint64_t lengthSquared(glm::ivec3 v)
+{
+    return static_cast<uint64_t>(static_cast<int64_t>(v.x) * v.x) +
+        static_cast<uint64_t>(static_cast<int64_t>(v.y) * v.y) +
+        static_cast<uint64_t>(static_cast<int64_t>(v.z) * v.z);
+}
+
+Region::Region(void)
+    : mChunkLoadList(ChunkScheduler::NEAREST_FIRST),
+      mChunkRemoveList(ChunkScheduler::FARTHEST_FIRST),
+      mChunkMeshList(ChunkScheduler::NEAREST_FIRST),
+      mChunkCache(CHUNK_CACHE_CAPACITY),
+      mGenerator(std::make_shared<TerrainGenerator>()),
+      mMeshWorkers(mJobs)
+{
+    mMaxChunkDistance = 256;
+    mChunkDistance = mMaxChunkDistance;
+    mUnloadDistance =
+        mChunkDistance + (UNLOAD_MARGIN_CHUNKS * horizontalChunkSize());
+    mCameraChunk = glm::ivec3(0, 0, 0);
+    mLoadSetValid = false;
+    mWrappedUp = false;
+    mPrefetchChunk = glm::ivec3(0, 0, 0);
+    mPrefetchValid = false;
+    mLodDistance = 64;
+    mLodChunk = glm::ivec3(0, 0, 0);
+    mLodValid = false;
+
+    // The chunks are loaded by the first update, once the camera is known.
+    buildLoadOffsets();
+}
+
+Region::~Region(void)
+{
+    // The chunks are owned by the pool.
 }
 
 void Region::initialize(void)
@@ -39,9 +145,14 @@ void Region::initialize(void)
     mUniformVP = mShaderProgram.getUniformLocation("ViewProjection");
     mUniformModel = mShaderProgram.getUniformLocation("Model");
 
-    for (std::pair<glm::ivec3, Chunk *> p : mChunks)
+    // The layout of the packed vertices depends on the size of a chunk.
+    glUniform3ui(mShaderProgram.getUniformLocation("PositionBits"),
+        ChunkVertex::POSITION_BITS_X, ChunkVertex::POSITION_BITS_Y,
+        ChunkVertex::POSITION_BITS_Z);
+
+    for (const std::pair<glm::ivec3, SlotHandleStruct> &p : mChunks)
     {
-        p.second->initialize();
+        mChunkPool.get(p.second)->initialize();
     }
 }
 
@@ -49,48 +160,115 @@ void Region::update(void)
 {
     mCameraController.update();
 
-    for (std::pair<glm::ivec3, Chunk *> p : mChunks)
-    {
-        // Check if the chunk has neighbors that need to be loaded.
-        if (p.second->getNumNeighbors() < 6)
-        {
-            // If not all the neighbors are loaded, then either this chunk needs
-            // to be unloaded or its neighbors need to be loaded.
-            updateChunkLists(p);
-        }
+    // Reprioritize the pending chunks for the new camera view.
+    glm::mat4 viewProjection = getProjection() * mCameraController.getView();
+    mChunkLoadList.setView(mCameraController.getPosition(),
+        mCameraController.getFacing(), viewProjection);
+    mChunkRemoveList.setView(mCameraController.getPosition(),
+        mCameraController.getFacing(), viewProjection);
+    mChunkMeshList.setView(mCameraController.getPosition(),
+        mCameraController.getFacing(), viewProjection);
 
-        // Update the Chunk
-        p.second->update();
-    }
+    updateLoadSet();
+    updateLods();
+    governMemory();
+    governMeshes();
+    prefetchChunks();
+
+    mStreamingBudget.begin(StreamingBudget::MESHING);
+    submitMeshes();
+    mStreamingBudget.end(mChunkMeshList.size() +
+        mMeshWorkers.getPendingJobs());
 
-    // Add and Remove Chunks from the hashmap.
+    mStreamingBudget.begin(StreamingBudget::UPLOAD);
+    uploadMeshes();
+    mStreamingBudget.end(mMeshWorkers.getPendingResults());
+
+    // Add and Remove Chunks from the hashmap. Collecting the chunks that have
+    // been read shares the generation budget with both, and unloading goes
+    // before loading so that the pool has free chunks.
+    mStreamingBudget.begin(StreamingBudget::GENERATION);
+    collectChunks();
     unloadChunks();
     loadChunks();
-
+    mStreamingBudget.end(mChunkLoadList.size() + mChunkRemoveList.size());
 }
 
 void Region::render(void)
 {
     glm::mat4 view = mCameraController.getView();
-    glm::mat4 proj = glm::perspective(
-        glm::radians(45.0f), 1.0f, 0.1f, 256.0f);
+    glm::mat4 proj = getProjection();
     glUniformMatrix4fv(mUniformVP, 1, GL_FALSE, glm::value_ptr(proj * view));
 
-    for (std::pair<glm::ivec3, Chunk *> p : mChunks)
+    for (const std::pair<glm::ivec3, SlotHandleStruct> &p : mChunks)
     {
         // Update the Model Matrix to position the chunk in the world.
         glm::mat4 model = glm::translate(
             glm::mat4(1),
-            glm::vec3(
-                p.first.x * Chunk::CHUNK_SIZE,
-                p.first.y * Chunk::CHUNK_SIZE,
-                p.first.z * Chunk::CHUNK_SIZE));
+            glm::vec3(p.first * Chunk::getChunkSize()));
 
         // Set the Model Matrix Uniform.
         glUniformMatrix4fv(mUniformModel, 1, GL_FALSE, glm::value_ptr(model));
 
-        p.second->render();
+        mChunkPool.get(p.second)->render();
+    }
+}
+
+void Region::wrapup(void)
+{
+    if (mWrappedUp)
+    {
+        return;
+    }
+    mWrappedUp = true;
+
+    // Save the chunks that are still loaded.
+    for (const std::pair<glm::ivec3, SlotHandleStruct> &p : mChunks)
+    {
+        saveChunk(p.first, *mChunkPool.get(p.second));
+    }
+
+    // Wait for the saves to be written.
+    mChunkLoader.flush();
+
+    mGenerator->printStatistics();
+    mJobs.printStatistics();
+    mMeshWorkers.printStatistics();
+    mStreamingBudget.printStatistics();
+    mChunkLoader.printStatistics();
+    mChunkCache.printStatistics();
+    mMemoryGovernor.printStatistics();
+    mMeshResidency.printStatistics();
+
+    // Count the chunks and the vertices drawn at each level of detail.
+    unsigned long lodChunks[Chunk::LOD_LEVELS] = {0};
+    unsigned long lodVertices[Chunk::LOD_LEVELS] = {0};
+    for (const std::pair<glm::ivec3, SlotHandleStruct> &p : mChunks)
+    {
+        Chunk *c = mChunkPool.get(p.second);
+        lodChunks[c->getLod()]++;
+
+        std::shared_ptr<ChunkMesh> mesh = c->getMesh();
+        if (mesh)
+        {
+            lodVertices[c->getLod()] += mesh->getVertexCount();
+        }
     }
+
+    std::cout << "Detail:";
+    for (int level = 0; level < Chunk::LOD_LEVELS; level++)
+    {
+        std::cout << ((level == 0) ? " " : ", ") << lodChunks[level]
+            << " chunks at " << (1 << level) << "x (" << lodVertices[level]
+            << " vertices)";
+    }
+    std::cout << std::endl;
+
+    std::cout << "Sharing: " << mChunks.size() << " chunks (pool of "
+        << mChunkPool.capacity() << "), "
+        << BlockStore::getStoreCount() << " block stores ("
+        << BlockStore::getTotalMemoryUsage() << " bytes), "
+        << ChunkMesh::getMeshCount() << " meshes" << std::endl;
 }
 
 void Region::useShader(ShaderProgram &shader)
@@ -115,198 +293,826 @@ void Region::useCameraController(CameraController &cc)
     mCameraController = cc;
 }
 
+void Region::useMeshingMode(ChunkMesher::MeshingModeEnum mode)
+{
+    mMeshWorkers.setMode(mode);
+
+    for (const std::pair<glm::ivec3, SlotHandleStruct> &p : mChunks)
+    {
+        mChunkPool.get(p.second)->requestUpdate();
+        mChunkMeshList.push(p.first);
+    }
+}
+
+void Region::compareMeshingModes(bool enable)
+{
+    mMeshWorkers.setCompareModes(enable);
+}
+
+void Region::useStreamingBudget(StreamingBudget::StageEnum stage,
+    double milliseconds)
+{
+    mStreamingBudget.setBudget(stage, milliseconds);
+}
+
+void Region::useGenerator(std::shared_ptr<ChunkGenerator> generator)
+{
+    mGenerator = generator;
+}
+
+void Region::useMemoryBudget(size_t bytes)
+{
+    mMemoryGovernor.setBudget(bytes);
+}
+
+void Region::useMeshBudget(size_t bytes)
+{
+    mMeshResidency.setBudget(bytes);
+}
+
+void Region::useLodDistance(unsigned int distance)
+{
+    mLodDistance = distance;
+    mLodValid = false;
+}
+
+void Region::useSaveDirectory(const std::string &directory)
+{
+    mChunkLoader.setDirectory(directory);
+}
+
 void Region::registerWith(InputManager &manager)
 {
     mCameraController.registerWith(manager);
 }
 
-void Region::updateChunkLists(std::pair<glm::ivec3, Chunk*> ci)
+glm::mat4 Region::getProjection(void)
 {
-    // The algorithm for updating the chunkmap is as follows:
-    // 1. Check if the chunk should be unloaded. If it is, add it to the list of
-    //    chunks to unload and return.
-    // 2. If the chunk shouldn't be unloaded, then check if each of its
-    //    neighbors to determine if they should be loaded.
-    // Note that this function does not actually add/remove chunks from the map;
-    // instead, it only updates the lists of chunks to load and unload.
+    return glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 256.0f);
+}
 
-    // The chunk load algorithm returns true if a chunk should be loaded and
-    // false if it should not be loaded.
-    if (!chunkLoadAlgorithm(ci.first))
+void Region::saveChunk(glm::ivec3 coords, Chunk &chunk)
+{
+    if (chunk.isSaveRequired() && mChunkLoader.isEnabled())
     {
-        mChunkRemoveList.push(ci.first);
-        return;
+        mChunkLoader.save(coords, *chunk.getBlockStore());
+        chunk.markSaved();
     }
+}
+
+void Region::uploadMeshes(void)
+{
+    MeshWorkerPool::MeshResultStruct result;
 
-    // If the chunk should be loaded, then check its neighbors to determine if
-    // they should also be loaded.
-    if (!(ci.second->hasNeighbor(Chunk::pX)) &&
-        chunkLoadAlgorithm(ci.first + glm::ivec3(1.0, 0.0, 0.0)))
+    while (mStreamingBudget.hasTime() && mMeshWorkers.collect(result))
     {
-        mChunkLoadList.push(ci.first + glm::ivec3(1.0, 0.0, 0.0));
+        mStreamingBudget.startItem();
+
+        // The chunk discards the mesh if it has changed since it was
+        // captured. Meshes of chunks that have been unloaded are dropped.
+        // Chunks that changed while they were being meshed are queued to be
+        // captured again.
+        SlotHandleStruct *handle = mChunks.find(result.coords);
+        if (handle != nullptr)
+        {
+            Chunk *c = mChunkPool.get(*handle);
+            c->endMeshing(result.revision, result.vertices);
+
+            if (c->isUpdateRequired())
+            {
+                mChunkMeshList.push(result.coords);
+            }
+        }
+
+        mMeshWorkers.recycle(result);
+        mStreamingBudget.complete();
     }
+}
 
-    if (!(ci.second->hasNeighbor(Chunk::nX)) &&
-        chunkLoadAlgorithm(ci.first + glm::ivec3(-1.0, 0.0, 0.0)))
+void Region::submitMeshes(void)
+{
+    ChunkMesher::MeshingModeEnum mode = mMeshWorkers.getMode();
+    unsigned int queuedJobs = mMeshWorkers.getPendingJobs();
+    unsigned int maxQueuedJobs =
+        mMeshWorkers.getWorkerCount() * QUEUED_MESH_JOBS_PER_WORKER;
+    glm::ivec3 coords;
+
+    while ((queuedJobs < maxQueuedJobs) && mStreamingBudget.hasTime() &&
+        mChunkMeshList.pop(coords))
     {
-        mChunkLoadList.push(ci.first + glm::ivec3(-1.0, 0.0, 0.0));
+        // Skip chunks that have been unloaded, evicted or already meshed. Only
+        // one mesh of a chunk is generated at a time; a chunk that changes
+        // while it is being meshed is queued again when its mesh is collected,
+        // and an evicted chunk is queued again when it is restored.
+        SlotHandleStruct *handle = mChunks.find(coords);
+        if (handle == nullptr)
+        {
+            continue;
+        }
+
+        Chunk *c = mChunkPool.get(*handle);
+        if (!c->isUpdateRequired() || c->isMeshing() || c->isMeshEvicted())
+        {
+            continue;
+        }
+
+        // Chunks identical to one that has been meshed share its mesh
+        // instead.
+        mStreamingBudget.startItem();
+        if (!c->shareMesh(mode))
+        {
+            mMeshWorkers.submit(coords, *c);
+            queuedJobs++;
+        }
+        mStreamingBudget.complete();
     }
+}
+
+void Region::buildLoadOffsets(void)
+{
+    buildOffsets(mChunkDistance, mLoadOffsets);
+    buildOffsets(mUnloadDistance, mUnloadOffsets);
+}
 
-    if (!(ci.second->hasNeighbor(Chunk::pY)) &&
-        chunkLoadAlgorithm(ci.first + glm::ivec3(0.0, 1.0, 0.0)))
+void Region::buildOffsets(unsigned int distance,
+    std::vector<LoadOffsetStruct> &offsets)
+{
+    // Chunks are in the sphere while the distance between their center and
+    // the center of the camera's chunk is less than the distance.
+    glm::ivec3 size = Chunk::getChunkSize();
+    glm::ivec3 radius = glm::ivec3(distance) / size;
+    uint64_t limit = static_cast<uint64_t>(distance) * distance;
+
+    offsets.clear();
+    for (int x = -radius.x; x <= radius.x; x++)
     {
-        mChunkLoadList.push(ci.first + glm::ivec3(0.0, 1.0, 0.0));
+        for (int y = -radius.y; y <= radius.y; y++)
+        {
+            for (int z = -radius.z; z <= radius.z; z++)
+            {
+                uint64_t distanceSquared =
+                    lengthSquared(glm::ivec3(x, y, z) * size);
+
+                if (distanceSquared < limit)
+                {
+                    offsets.push_back(
+                        LoadOffsetStruct{glm::ivec3(x, y, z), distanceSquared});
+                }
+            }
+        }
     }
 
-    if (!(ci.second->hasNeighbor(Chunk::nY)) &&
-        chunkLoadAlgorithm(ci.first + glm::ivec3(0.0, -1.0, 0.0)))
+    std::sort(offsets.begin(), offsets.end(),
+        [](const LoadOffsetStruct &a, const LoadOffsetStruct &b) {
+            return a.distanceSquared < b.distanceSquared;
+        });
+}
+
+std::vector<Region::LoadOffsetStruct>::iterator Region::findShell(
+    std::vector<LoadOffsetStruct> &offsets, unsigned int distance,
+    glm::ivec3 move)
+{
+    // The shell is widened by a block to stay clear of rounding.
+    float inner = static_cast<float>(distance) -
+        glm::length(glm::vec3(move * Chunk::getChunkSize())) - 1.0f;
+    uint64_t innerSquared = (inner > 0.0f)
+        ? static_cast<uint64_t>(inner) * static_cast<uint64_t>(inner) : 0;
+
+    return std::lower_bound(offsets.begin(), offsets.end(), innerSquared,
+        [](const LoadOffsetStruct &o, uint64_t distanceSquared) {
+            return o.distanceSquared < distanceSquared;
+        });
+}
+
+void Region::resizeLoadSphere(unsigned int distance)
+{
+    unsigned int previous = mChunkDistance;
+    mChunkDistance = distance;
+    mUnloadDistance =
+        distance + (UNLOAD_MARGIN_CHUNKS * horizontalChunkSize());
+    buildLoadOffsets();
+
+    // The prefetches were chosen for the previous sphere.
+    mPrefetchValid = false;
+
+    if (!mLoadSetValid)
     {
-        mChunkLoadList.push(ci.first + glm::ivec3(0.0, -1.0, 0.0));
+        return;
     }
 
-    if (!(ci.second->hasNeighbor(Chunk::pZ)) &&
-        chunkLoadAlgorithm(ci.first + glm::ivec3(0.0, 0.0, 1.0)))
+    if (distance < previous)
     {
-        mChunkLoadList.push(ci.first + glm::ivec3(0.0, 0.0, 1.0));
+        for (const std::pair<glm::ivec3, SlotHandleStruct> &p : mChunks)
+        {
+            if (chunkUnloadAlgorithm(p.first))
+            {
+                mChunkRemoveList.push(p.first);
+            }
+        }
+
+        return;
     }
 
-    if (!(ci.second->hasNeighbor(Chunk::nZ)) &&
-        chunkLoadAlgorithm(ci.first + glm::ivec3(0.0, 0.0, -1.0)))
+    // Only the offsets past the previous distance are new.
+    uint64_t previousSquared = static_cast<uint64_t>(previous) * previous;
+    std::vector<LoadOffsetStruct>::iterator it = std::lower_bound(
+        mLoadOffsets.begin(), mLoadOffsets.end(), previousSquared,
+        [](const LoadOffsetStruct &o, uint64_t distanceSquared) {
+            return o.distanceSquared < distanceSquared;
+        });
+
+    for (; it != mLoadOffsets.end(); ++it)
     {
-        mChunkLoadList.push(ci.first + glm::ivec3(0.0, 0.0, -1.0));
+        mChunkLoadList.push(mCameraChunk + it->offset);
     }
 }
 
-bool Region::chunkLoadAlgorithm(glm::ivec3 coords)
+void Region::governMemory(void)
 {
-    // Use the camera's distance from the center of the chunk to determine if
-    // it should be loaded or not.
-    glm::vec3 cameraPos = mCameraController.getPosition();
-    glm::vec3 chunkWorldPos = Chunk::chunkCenterToWorldCoords(coords);
+    if (!mMemoryGovernor.isEnabled())
+    {
+        return;
+    }
 
-    return (glm::distance(cameraPos, chunkWorldPos) < mChunkDistance);
+    // The pool keeps its capacity after chunks are unloaded, and the chunks
+    // read or written by the loader are held in its buffers until they are
+    // collected or saved, so both are counted with the chunks.
+    mMemoryGovernor.setUsage(MemoryGovernor::BLOCK_STORES,
+        BlockStore::getTotalMemoryUsage());
+    mMemoryGovernor.setUsage(MemoryGovernor::CHUNKS,
+        (mChunkPool.capacity() * sizeof(Chunk)) +
+        mChunkLoader.getMemoryUsage());
+    mMemoryGovernor.setUsage(MemoryGovernor::MESH_BUFFERS,
+        mMeshWorkers.getMemoryUsage());
+
+    unsigned int step = horizontalChunkSize();
+
+    if (mMemoryGovernor.isOverBudget())
+    {
+        // The cached chunks, and the resident and generated chunks that the
+        // camera is not expected to reach, are not visible, so they are
+        // dropped before any loaded chunks. Half of the cache goes at a time,
+        // oldest first. The chunks waiting to be loaded are kept, so their
+        // work is not repeated.
+        unsigned int dropped = mChunkCache.trim((mChunkCache.size() + 1) / 2) +
+            dropStaleChunks(mResidentChunks, 0) +
+            dropStaleChunks(mGeneratedChunks, 0);
+        if (dropped > 0)
+        {
+            return;
+        }
+
+        // Wait for the previous shrink to be unloaded before measuring again.
+        if ((mChunkRemoveList.size() > 0) ||
+            (mChunkDistance <= MIN_CHUNK_DISTANCE))
+        {
+            return;
+        }
+
+        resizeLoadSphere((mChunkDistance > MIN_CHUNK_DISTANCE + step)
+            ? mChunkDistance - step : MIN_CHUNK_DISTANCE);
+        mMemoryGovernor.recordDistance(mChunkDistance, true);
+        return;
+    }
+
+    // Grow back once the previous load set is complete, and only if the
+    // larger sphere is expected to fit. The memory grows with the volume of
+    // the sphere.
+    if ((mChunkDistance >= mMaxChunkDistance) || (mChunkLoadList.size() > 0))
+    {
+        return;
+    }
+
+    unsigned int distance = std::min(mChunkDistance + step, mMaxChunkDistance);
+    double ratio = static_cast<double>(distance) / mChunkDistance;
+    if (mMemoryGovernor.canGrow(ratio * ratio * ratio))
+    {
+        resizeLoadSphere(distance);
+        mMemoryGovernor.recordDistance(mChunkDistance, false);
+    }
 }
 
-void Region::loadChunks(void)
+void Region::governMeshes(void)
 {
-    unsigned int chunkCounter = 0;
+    size_t usage = ChunkMesh::getTotalMemoryUsage();
+    if (!mMeshResidency.update(usage))
+    {
+        return;
+    }
 
-    while ((mChunkLoadList.size() > 0) && (chunkCounter < mChunkLoadRate))
+    // Cached chunks are not drawn, so their meshes are dropped first, along
+    // with the buffers that are kept for reuse.
+    if (usage > mMeshResidency.getBudget())
     {
-        glm::ivec3 coords = mChunkLoadList.front();
+        mChunkCache.releaseMeshes();
+        ChunkMesh::deleteFreeBuffers();
+        usage = ChunkMesh::getTotalMemoryUsage();
+    }
 
-        // Prevent duplicate loads.
-        if (mChunks.find(coords) != mChunks.end())
+    // Chunks without faces never need a mesh, so only the chunks that have,
+    // need or had one are planned.
+    std::vector<MeshResidency::CandidateStruct> candidates;
+    for (const std::pair<glm::ivec3, SlotHandleStruct> &p : mChunks)
+    {
+        Chunk *c = mChunkPool.get(p.second);
+        std::shared_ptr<ChunkMesh> mesh = c->getMesh();
+        if (!mesh && !c->isMeshEvicted() && !c->isUpdateRequired() &&
+            !c->isMeshing())
         {
-            mChunkLoadList.pop();
             continue;
         }
 
-        Chunk *c = new Chunk(coords.x, coords.y, coords.z);
+        candidates.push_back(MeshResidency::CandidateStruct{p.first,
+            mChunkMeshList.prioritize(p.first), mesh.get(),
+            mesh ? mesh->getMemoryUsage() : 0, c->isMeshEvicted()});
+    }
 
-        // Connect the neighbors.
-        auto npx = mChunks.find(coords + glm::ivec3(1.0, 0.0, 0.0));
-        if (npx != mChunks.end())
+    std::vector<glm::ivec3> evict;
+    std::vector<glm::ivec3> restore;
+    mMeshResidency.plan(usage, candidates, evict, restore);
+
+    for (glm::ivec3 coords : evict)
+    {
+        mChunkPool.get(*mChunks.find(coords))->evictMesh();
+    }
+
+    // The buffers of the evicted meshes would otherwise be kept for reuse.
+    if (!evict.empty())
+    {
+        ChunkMesh::deleteFreeBuffers();
+    }
+
+    for (glm::ivec3 coords : restore)
+    {
+        mChunkPool.get(*mChunks.find(coords))->restoreMesh();
+        mChunkMeshList.push(coords);
+    }
+}
+
+void Region::updateLoadSet(void)
+{
+    glm::ivec3 center =
+        Chunk::worldToChunkCoords(mCameraController.getPosition());
+
+    if (!mLoadSetValid)
+    {
+        // Queue the whole sphere, nearest first.
+        for (const LoadOffsetStruct &o : mLoadOffsets)
         {
-            npx->second->setNeighbor(Chunk::nX, c);
-            c->setNeighbor(Chunk::pX, npx->second);
+            mChunkLoadList.push(center + o.offset);
         }
 
-        auto nnx = mChunks.find(coords + glm::ivec3(-1.0, 0.0, 0.0));
-        if (nnx != mChunks.end())
+        mCameraChunk = center;
+        mLoadSetValid = true;
+        return;
+    }
+
+    if (center == mCameraChunk)
+    {
+        return;
+    }
+
+    // Only the outer shells of the offsets need to be compared. Chunks
+    // entering the new load sphere are loaded.
+    glm::ivec3 move = center - mCameraChunk;
+    for (std::vector<LoadOffsetStruct>::iterator it =
+        findShell(mLoadOffsets, mChunkDistance, move);
+        it != mLoadOffsets.end(); ++it)
+    {
+        glm::ivec3 entering = center + it->offset;
+        if (!isInLoadSphere(entering, mCameraChunk))
         {
-            nnx->second->setNeighbor(Chunk::pX, c);
-            c->setNeighbor(Chunk::nX, nnx->second);
+            mChunkLoadList.push(entering);
         }
+    }
+
+    // Chunks leaving the old unload sphere are unloaded.
+    for (std::vector<LoadOffsetStruct>::iterator it =
+        findShell(mUnloadOffsets, mUnloadDistance, move);
+        it != mUnloadOffsets.end(); ++it)
+    {
+        glm::ivec3 leaving = mCameraChunk + it->offset;
+        if (!isInUnloadSphere(leaving, center))
+        {
+            mChunkRemoveList.push(leaving);
+        }
+    }
+
+    mCameraChunk = center;
+}
+
+void Region::updateLods(void)
+{
+    if (mLodValid && (mLodChunk == mCameraChunk))
+    {
+        return;
+    }
+    mLodChunk = mCameraChunk;
+    mLodValid = true;
 
-        auto npy = mChunks.find(coords + glm::ivec3(0.0, 1.0, 0.0));
-        if (npy != mChunks.end())
+    for (const std::pair<glm::ivec3, SlotHandleStruct> &p : mChunks)
+    {
+        Chunk *c = mChunkPool.get(p.second);
+        if (!c->setLod(chunkLodAlgorithm(p.first, c->getLod())))
         {
-            npy->second->setNeighbor(Chunk::nY, c);
-            c->setNeighbor(Chunk::pY, npy->second);
+            continue;
         }
+        mChunkMeshList.push(p.first);
 
-        auto nny = mChunks.find(coords + glm::ivec3(0.0, -1.0, 0.0));
-        if (nny != mChunks.end())
+        // A chunk of a single type draws the same cells at every level, so
+        // its neighbors are unaffected.
+        if (c->getBlockStore()->isUniform())
         {
-            nny->second->setNeighbor(Chunk::pY, c);
-            c->setNeighbor(Chunk::nY, nny->second);
+            continue;
         }
 
-        auto npz = mChunks.find(coords + glm::ivec3(0.0, 0.0, 1.0));
-        if (npz != mChunks.end())
+        for (int dir = Chunk::pX; dir <= Chunk::nZ; dir++)
         {
-            npz->second->setNeighbor(Chunk::nZ, c);
-            c->setNeighbor(Chunk::pZ, npz->second);
+            Chunk *neighbor =
+                c->getNeighbor(static_cast<Chunk::ChunkDirectionEnum>(dir));
+            if (neighbor != nullptr)
+            {
+                neighbor->requestUpdate();
+                mChunkMeshList.push(p.first + NEIGHBOR_OFFSETS[dir]);
+            }
         }
+    }
+}
+
+void Region::prefetchChunks(void)
+{
+    // Prefetches would only compete with the chunks that are already needed
+    // while the load list is behind.
+    if (!mChunkLoader.isEnabled() ||
+        (mChunkLoadList.size() > MAX_PENDING_READS))
+    {
+        return;
+    }
+
+    glm::ivec3 target = Chunk::worldToChunkCoords(
+        mCameraController.getPosition() +
+        (mCameraController.getVelocity() * PREFETCH_TICKS));
+
+    if (mPrefetchValid && (target == mPrefetchChunk))
+    {
+        return;
+    }
 
-        auto nnz = mChunks.find(coords + glm::ivec3(0.0, 0.0, -1.0));
-        if (nnz != mChunks.end())
+    // The previous prediction no longer holds, so its remaining prefetches
+    // are replaced.
+    mChunkLoader.clearPrefetches();
+    mPrefetchChunk = target;
+    mPrefetchValid = true;
+
+    if (target == mCameraChunk)
+    {
+        return;
+    }
+
+    std::vector<glm::ivec3> ahead;
+    for (std::vector<LoadOffsetStruct>::iterator it =
+        findShell(mLoadOffsets, mChunkDistance, target - mCameraChunk);
+        it != mLoadOffsets.end(); ++it)
+    {
+        glm::ivec3 coords = target + it->offset;
+        if (!isInLoadSphere(coords, mCameraChunk) &&
+            (mChunks.find(coords) == nullptr) &&
+            !mChunkCache.contains(coords) &&
+            (mResidentChunks.find(coords) == nullptr))
         {
-            nnz->second->setNeighbor(Chunk::pZ, c);
-            c->setNeighbor(Chunk::nZ, nnz->second);
+            ahead.push_back(coords);
         }
+    }
 
-        c->initialize();
-        mChunks.insert({coords, c});
+    // The camera reaches the chunks nearest to it first.
+    glm::ivec3 center = mCameraChunk;
+    std::sort(ahead.begin(), ahead.end(),
+        [center](const glm::ivec3 &a, const glm::ivec3 &b) {
+            return lengthSquared(a - center) < lengthSquared(b - center);
+        });
 
-        mChunkLoadList.pop();
-        chunkCounter++;
+    for (const glm::ivec3 &coords : ahead)
+    {
+        mChunkLoader.request(coords, true);
     }
 }
 
-void Region::unloadChunks(void)
+void Region::collectChunks(void)
 {
-    unsigned int chunkCounter = 0;
+    ChunkLoader::LoadResultStruct result;
 
-    while ((mChunkRemoveList.size() > 0) && (chunkCounter < mChunkUnloadRate))
+    while (mStreamingBudget.hasTime() && mChunkLoader.collect(result))
     {
-        glm::ivec3 coords = mChunkRemoveList.front();
+        mStreamingBudget.startItem();
 
-        // Prevent duplicate unloads.
-        if (mChunks.find(coords) == mChunks.end())
+        // Chunks that have been loaded since they were requested are already
+        // up to date.
+        if (mChunks.find(result.coords) == nullptr)
         {
-            mChunkRemoveList.pop();
-            continue;
+            std::shared_ptr<const BlockStore> blocks;
+            if (result.found && result.uniform)
+            {
+                blocks = BlockStore::internUniform(result.blocks[0]);
+            }
+            else if (result.found)
+            {
+                blocks = BlockStore::intern(result.blocks.data());
+            }
+
+            if (mResidentChunks.insert(result.coords, blocks) &&
+                chunkLoadAlgorithm(result.coords))
+            {
+                mChunkLoadList.push(result.coords);
+            }
         }
 
-        Chunk *c = mChunks.at(coords);
+        mChunkLoader.recycle(result);
+        mStreamingBudget.complete();
+    }
 
-        // Disconnect the neighbors.
-        if (c->hasNeighbor(Chunk::pX))
+    // The continuations of the generation jobs intern the generated blocks.
+    while (mStreamingBudget.hasTime())
+    {
+        mStreamingBudget.startItem();
+        if (!mJobs.runMainThreadJob())
         {
-            c->getNeighbor(Chunk::pX)->setNeighbor(Chunk::nX, nullptr);
+            break;
         }
+        mStreamingBudget.complete();
+    }
+
+    dropStaleChunks(mResidentChunks, MAX_RESIDENT_CHUNKS);
+    dropStaleChunks(mGeneratedChunks, MAX_RESIDENT_CHUNKS);
+}
+
+unsigned int Region::dropStaleChunks(
+    CoordinateMap<std::shared_ptr<const BlockStore>> &chunks,
+    unsigned int limit)
+{
+    if (chunks.size() <= limit)
+    {
+        return 0;
+    }
 
-        if (c->hasNeighbor(Chunk::nX))
+    // Drop the chunks that the camera is no longer expected to reach.
+    std::vector<glm::ivec3> stale;
+    for (const std::pair<glm::ivec3, std::shared_ptr<const BlockStore>> &p :
+        chunks)
+    {
+        if (!chunkLoadAlgorithm(p.first) &&
+            !(mPrefetchValid && isInLoadSphere(p.first, mPrefetchChunk)))
         {
-            c->getNeighbor(Chunk::nX)->setNeighbor(Chunk::pX, nullptr);
+            stale.push_back(p.first);
         }
+    }
+
+    for (const glm::ivec3 &coords : stale)
+    {
+        chunks.erase(coords);
+    }
+
+    return stale.size();
+}
+
+void Region::generateChunk(glm::ivec3 coords)
+{
+    // The blocks are passed from the worker to the continuation. The job
+    // keeps its own reference to the generator, in case it is replaced.
+    std::shared_ptr<std::vector<BlockId>> blocks =
+        std::make_shared<std::vector<BlockId>>(Chunk::BLOCK_COUNT);
+    std::shared_ptr<bool> uniform = std::make_shared<bool>(false);
+    std::shared_ptr<ChunkGenerator> generator = mGenerator;
+
+    JobSystem::JobHandle job = mJobs.submit([=](void) {
+        *uniform = generator->generate(coords, blocks->data());
+    });
 
-        if (c->hasNeighbor(Chunk::pY))
+    // Blocks are interned on the main thread.
+    mJobs.then(job, [=](void) {
+        mGenerations.erase(coords);
+
+        std::shared_ptr<const BlockStore> store = *uniform
+            ? BlockStore::internUniform((*blocks)[0])
+            : BlockStore::intern(blocks->data());
+
+        if (mGeneratedChunks.insert(coords, store) &&
+            chunkLoadAlgorithm(coords))
         {
-            c->getNeighbor(Chunk::pY)->setNeighbor(Chunk::nY, nullptr);
+            mChunkLoadList.push(coords);
         }
+    }, JobSystem::MAIN_THREAD);
+
+    mGenerations.insert(coords, job);
+}
+
+bool Region::isInLoadSphere(glm::ivec3 coords, glm::ivec3 center)
+{
+    return lengthSquared((coords - center) * Chunk::getChunkSize()) <
+        static_cast<uint64_t>(mChunkDistance) * mChunkDistance;
+}
+
+bool Region::isInUnloadSphere(glm::ivec3 coords, glm::ivec3 center)
+{
+    return lengthSquared((coords - center) * Chunk::getChunkSize()) <
+        static_cast<uint64_t>(mUnloadDistance) * mUnloadDistance;
+}
+
+bool Region::chunkLoadAlgorithm(glm::ivec3 coords)
+{
+    // Use the distance from the chunk containing the camera to determine if
+    // the chunk should be loaded or not.
+    return isInLoadSphere(coords, mCameraChunk);
+}
+
+int Region::chunkLodAlgorithm(glm::ivec3 coords, int current)
+{
+    if (mLodDistance == 0)
+    {
+        return 0;
+    }
+
+    double distance = std::sqrt(static_cast<double>(
+        lengthSquared((coords - mCameraChunk) * Chunk::getChunkSize())));
+    int level = lodForDistance(distance, mLodDistance);
+    if (level <= current)
+    {
+        return level;
+    }
+
+    double margin = static_cast<double>(LOD_MARGIN_CHUNKS) *
+        horizontalChunkSize();
+    return std::max(current, lodForDistance(distance - margin, mLodDistance));
+}
+
+bool Region::chunkUnloadAlgorithm(glm::ivec3 coords)
+{
+    // Chunks are kept until they are past the unload distance, which is
+    // farther than the load distance.
+    return !isInUnloadSphere(coords, mCameraChunk);
+}
+
+void Region::loadChunks(void)
+{
+    glm::ivec3 coords;
+    bool storage = mChunkLoader.isEnabled();
+    unsigned int pendingReads = storage ? mChunkLoader.getPendingReads() : 0;
 
-        if (c->hasNeighbor(Chunk::nY))
+    while (mStreamingBudget.hasTime() && (pendingReads < MAX_PENDING_READS) &&
+        (mGenerations.size() < MAX_PENDING_GENERATIONS) &&
+        mChunkLoadList.pop(coords))
+    {
+        // Skip chunks that are already loaded, and chunks that the camera has
+        // moved away from since they were queued.
+        if ((mChunks.find(coords) != nullptr) || !chunkLoadAlgorithm(coords))
+        {
+            continue;
+        }
+
+        // Recently unloaded chunks are revived from the cache. Otherwise,
+        // chunks that have not been read yet are requested from the loader,
+        // and queued again once they are resident.
+        ChunkCache::CachedChunkStruct cached;
+        bool revived = mChunkCache.take(coords, cached);
+        std::shared_ptr<const BlockStore> blocks = cached.blocks;
+        if (!revived && storage)
+        {
+            std::shared_ptr<const BlockStore> *resident =
+                mResidentChunks.find(coords);
+            if (resident == nullptr)
+            {
+                if (mChunkLoader.request(coords, false))
+                {
+                    pendingReads++;
+                }
+                continue;
+            }
+
+            blocks = *resident;
+        }
+
+        // Chunks that have never been saved are generated by the jobs, and
+        // queued again once they have been generated.
+        bool generated = !blocks;
+        if (generated)
+        {
+            std::shared_ptr<const BlockStore> *generatedBlocks =
+                mGeneratedChunks.find(coords);
+            if (generatedBlocks == nullptr)
+            {
+                if (mGenerations.find(coords) == nullptr)
+                {
+                    generateChunk(coords);
+                }
+                continue;
+            }
+
+            blocks = *generatedBlocks;
+            mGeneratedChunks.erase(coords);
+        }
+        mResidentChunks.erase(coords);
+
+        mStreamingBudget.startItem();
+
+        SlotHandleStruct handle = mChunkPool.insert();
+        Chunk *c = mChunkPool.get(handle);
+        c->reset(&mChunkPool, coords.x, coords.y, coords.z, blocks,
+            !generated);
+
+        // A new chunk takes the level of detail of its distance right away.
+        c->setLod(chunkLodAlgorithm(coords, Chunk::LOD_LEVELS - 1));
+
+        // Connect the neighbors.
+        for (int dir = Chunk::pX; dir <= Chunk::nZ; dir++)
+        {
+            glm::ivec3 neighborCoords = coords + NEIGHBOR_OFFSETS[dir];
+            SlotHandleStruct *neighborHandle = mChunks.find(neighborCoords);
+            if (neighborHandle == nullptr)
+            {
+                continue;
+            }
+
+            Chunk *neighbor = mChunkPool.get(*neighborHandle);
+            unsigned long revision = neighbor->getRevision();
+
+            neighbor->setNeighbor(oppositeDirection(dir), handle);
+            c->setNeighbor(static_cast<Chunk::ChunkDirectionEnum>(dir),
+                *neighborHandle);
+            mChunkMeshList.push(neighborCoords);
+
+            // A neighbor that has not changed since the chunk was unloaded
+            // gets back the mesh it had while they were connected.
+            const ChunkCache::CachedNeighborStruct &n = cached.neighbors[dir];
+            if (revived && n.mesh && (n.revision == revision))
+            {
+                neighbor->useMesh(n.mesh);
+            }
+        }
+
+        // A revived chunk draws its previous mesh, which is shared again
+        // when it is meshed if its neighbors are the same.
+        if (revived)
         {
-            c->getNeighbor(Chunk::nY)->setNeighbor(Chunk::pY, nullptr);
+            c->useMesh(cached.mesh);
         }
 
-        if (c->hasNeighbor(Chunk::pZ))
+        c->initialize();
+        mChunks.insert(coords, handle);
+        mChunkMeshList.push(coords);
+
+        mStreamingBudget.complete();
+    }
+}
+
+void Region::unloadChunks(void)
+{
+    glm::ivec3 coords;
+
+    while (mStreamingBudget.hasTime() && mChunkRemoveList.pop(coords))
+    {
+        // Skip chunks that are already unloaded, and chunks that the camera
+        // has moved back towards since they were queued.
+        SlotHandleStruct *entry = mChunks.find(coords);
+        if ((entry == nullptr) || !chunkUnloadAlgorithm(coords))
         {
-            c->getNeighbor(Chunk::pZ)->setNeighbor(Chunk::nZ, nullptr);
+            continue;
         }
 
-        if (c->hasNeighbor(Chunk::nZ))
+        mStreamingBudget.startItem();
+
+        SlotHandleStruct handle = *entry;
+        Chunk *c = mChunkPool.get(handle);
+        saveChunk(coords, *c);
+
+        ChunkCache::CachedChunkStruct cached;
+        cached.blocks = c->getBlockStore();
+        cached.mesh = c->getMesh();
+
+        // Disconnect the neighbors, whose border faces are now exposed. Their
+        // meshes are cached with the chunk, along with their revisions once
+        // they no longer have the chunk as a neighbor.
+        for (int dir = Chunk::pX; dir <= Chunk::nZ; dir++)
         {
-            c->getNeighbor(Chunk::nZ)->setNeighbor(Chunk::pZ, nullptr);
+            Chunk *neighbor =
+                c->getNeighbor(static_cast<Chunk::ChunkDirectionEnum>(dir));
+            if (neighbor == nullptr)
+            {
+                continue;
+            }
+
+            cached.neighbors[dir].mesh = neighbor->getMesh();
+            neighbor->setNeighbor(oppositeDirection(dir),
+                SlotHandleStruct{0, 0});
+            cached.neighbors[dir].revision = neighbor->getRevision();
+            mChunkMeshList.push(coords + NEIGHBOR_OFFSETS[dir]);
         }
 
-        delete c;
+        mChunkCache.insert(coords, cached);
+
+        // Return the chunk to the pool to be reused by a later load.
+        c->clear();
+        mChunkPool.erase(handle);
         mChunks.erase(coords);
 
-        mChunkRemoveList.pop();
-        chunkCounter++;
+        mStreamingBudget.complete();
     }
 }
@@ -10,17 +10,32 @@
 #ifndef _CAMBRE_REGION_H_
 #define _CAMBRE_REGION_H_
 
-#include <queue>
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
 #include "CameraController.hpp"
+#include "BlockStore.hpp"
 #include "Chunk.hpp"
+#include "ChunkCache.hpp"
+#include "ChunkGenerator.hpp"
+#include "ChunkLoader.hpp"
+#include "ChunkMesher.hpp"
+#include "ChunkScheduler.hpp"
+#include "CoordinateMap.hpp"
 #include "DynamicObjectInterface.hpp"
 #include "InputManager.hpp"
+#include "JobSystem.hpp"
+#include "MemoryGovernor.hpp"
+#include "MeshResidency.hpp"
+#include "MeshWorkerPool.hpp"
 #include "ShaderProgram.hpp"
-#include "Specialization.hpp"
+#include "SlotMap.hpp"
+#include "StreamingBudget.hpp"
 
 /// @class Region
 /// @brief A class to handle multiple chunks.
@@ -36,6 +51,7 @@ public:
     void initialize(void);
     void update(void);
     void render(void);
+    void wrapup(void);
 
     /// @brief Use the ShaderProgram for rendering.
     ///
@@ -47,6 +63,65 @@ public:
     /// This call sets the camera controller for use when rendering the region.
     void useCameraController(CameraController &cc);
 
+    /// @brief Use the generator for chunks that have not been saved.
+    ///
+    /// The region generates noise based terrain by default. The generator
+    /// should be set before the first update, since chunks that are already
+    /// loaded, generated or saved keep their blocks. The generator is called
+    /// from the job system's worker threads.
+    void useGenerator(std::shared_ptr<ChunkGenerator> generator);
+
+    /// @brief Use the meshing mode for meshing chunks.
+    ///
+    /// This call sets the algorithm used to mesh chunks. All loaded chunks are
+    /// meshed again with the new mode.
+    void useMeshingMode(ChunkMesher::MeshingModeEnum mode);
+
+    /// @brief Compare the meshing modes while meshing chunks.
+    ///
+    /// When enabled, every chunk is meshed with each meshing mode, and the
+    /// vertex counts and meshing times are printed during wrapup.
+    void compareMeshingModes(bool enable);
+
+    /// @brief Use the time budget for a stage of chunk streaming.
+    ///
+    /// This call sets the milliseconds per tick that the stage may spend on
+    /// the main thread. Work that does not fit is left for later ticks.
+    void useStreamingBudget(StreamingBudget::StageEnum stage,
+        double milliseconds);
+
+    /// @brief Use the memory budget for the loaded chunks.
+    ///
+    /// While the chunks use more than the budget, the cached and resident
+    /// chunks are dropped and the load distance shrinks, unloading the
+    /// farthest chunks and those out of view first. The distance grows back
+    /// once the chunks fit comfortably. A budget of zero removes the limit.
+    void useMemoryBudget(size_t bytes);
+
+    /// @brief Use the video memory budget for the chunk meshes.
+    ///
+    /// While the vertex buffers use more than the budget, the meshes of the
+    /// cached chunks are dropped, then those of the farthest chunks and the
+    /// chunks out of view are evicted. Evicted chunks keep their blocks and
+    /// are meshed again once they fit. A budget of zero removes the limit.
+    void useMeshBudget(size_t bytes);
+
+    /// @brief Use the distance at which chunks are meshed at lower detail.
+    ///
+    /// Chunks within the distance, in blocks, of the chunk containing the
+    /// camera are meshed at full detail. Each doubling of the distance past
+    /// it merges the blocks into cells twice as large, down to cells of 8
+    /// blocks along each axis. A distance of zero meshes every chunk at full
+    /// detail.
+    void useLodDistance(unsigned int distance);
+
+    /// @brief Use the directory to save chunks.
+    ///
+    /// Chunks are read from the directory when they are loaded, and only
+    /// generated if they have not been saved. Generated and edited chunks are
+    /// saved when they are unloaded and during wrapup.
+    void useSaveDirectory(const std::string &directory);
+
     /// @brief Register to listen for inputs.
     ///
     /// This function attaches the region to an input manager so it can be
@@ -55,49 +130,301 @@ public:
 
 private:
     /// @brief The set of chunks managed by the Region.
-    std::unordered_map<glm::ivec3, Chunk*> mChunks;
+    ///
+    /// The chunks are handles into mChunkPool, indexed by their coordinates in
+    /// a flat hash map so that lookups stay within one array.
+    CoordinateMap<SlotHandleStruct> mChunks;
+
+    /// @brief The pool that the chunks are allocated from.
+    ///
+    /// Unloaded chunks are returned to the pool and reused by later loads, so
+    /// streaming does not allocate or free chunks.
+    SlotMap<Chunk> mChunkPool;
+
+    /// @brief The background thread that reads and writes saved chunks.
+    ChunkLoader mChunkLoader;
+
+    /// @brief The chunks that have been read but not loaded.
+    ///
+    /// A null store marks a chunk that has never been saved and is generated
+    /// when it is loaded. Loading a chunk removes it from this map.
+    CoordinateMap<std::shared_ptr<const BlockStore>> mResidentChunks;
+
+    /// @brief The chunk the camera is expected to reach when the prefetches
+    /// were last queued.
+    glm::ivec3 mPrefetchChunk;
+
+    /// @brief A flag indicating prefetches have been queued.
+    bool mPrefetchValid;
 
     /// @brief The distance used to render chunks.
+    ///
+    /// This is reduced below mMaxChunkDistance while memory is short.
     unsigned int mChunkDistance;
 
-    /// @brief The rate used to load/unload chunks.
-    unsigned int mChunkLoadRate;
-    unsigned int mChunkUnloadRate;
+    /// @brief The distance used to render chunks when memory allows.
+    unsigned int mMaxChunkDistance;
+
+    /// @brief The distance that chunks are meshed at full detail within.
+    unsigned int mLodDistance;
+
+    /// @brief The chunk containing the camera when the levels of detail were
+    /// last chosen.
+    glm::ivec3 mLodChunk;
+
+    /// @brief A flag indicating the levels of detail have been chosen.
+    bool mLodValid;
+
+    /// @brief The distance that loaded chunks are kept within.
+    ///
+    /// This is farther than the chunk distance, so that chunks near the edge
+    /// of the load sphere are not unloaded and loaded again as the camera
+    /// moves back and forth.
+    unsigned int mUnloadDistance;
+
+    /// @brief A struct containing the offset of a chunk in the load sphere.
+    ///
+    /// The distance is measured in blocks between the centers of the chunk
+    /// and the chunk at the center of the sphere.
+    struct LoadOffsetStruct
+    {
+        glm::ivec3 offset;
+        uint64_t distanceSquared;
+    };
+
+    /// @brief The offsets of every chunk within the load and unload
+    /// distances.
+    ///
+    /// The offsets are sorted by distance, nearest first.
+    std::vector<LoadOffsetStruct> mLoadOffsets;
+    std::vector<LoadOffsetStruct> mUnloadOffsets;
+
+    /// @brief The chunk containing the camera when the load set was last
+    /// computed.
+    glm::ivec3 mCameraChunk;
+
+    /// @brief A flag indicating the load set has been computed.
+    bool mLoadSetValid;
+
+    /// @brief A flag indicating the region has been wrapped up.
+    ///
+    /// The application wraps up a dynamic object as both a renderer and an
+    /// updater, so the chunks are saved and the statistics printed only once.
+    bool mWrappedUp;
+
+    /// @brief The time budgets used to load, mesh and upload chunks.
+    StreamingBudget mStreamingBudget;
+
+    /// @brief The memory budget of the loaded chunks.
+    MemoryGovernor mMemoryGovernor;
+
+    /// @brief The video memory budget of the chunk meshes.
+    MeshResidency mMeshResidency;
 
     /// @brief The queues used to keep track of chunks to load and unload.
-    std::queue<glm::ivec3> mChunkLoadList;
-    std::queue<glm::ivec3> mChunkRemoveList;
+    ///
+    /// Chunks are loaded nearest first and unloaded farthest first, both
+    /// favoring the chunks in view.
+    ChunkScheduler mChunkLoadList;
+    ChunkScheduler mChunkRemoveList;
+
+    /// @brief The queue of chunks that need to be meshed.
+    ///
+    /// Chunks are queued whenever they are loaded or their neighbors change,
+    /// so the region does not need to visit every chunk to find them.
+    ChunkScheduler mChunkMeshList;
+
+    /// @brief The recently unloaded chunks.
+    ///
+    /// Chunks in the cache are loaded again with their blocks and meshes
+    /// instead of being read, generated or meshed.
+    ChunkCache mChunkCache;
+
+    /// @brief The generator of the chunks that have not been saved.
+    std::shared_ptr<ChunkGenerator> mGenerator;
+
+    /// @brief The chunks that have been generated but not loaded.
+    ///
+    /// Loading a chunk removes it from this map.
+    CoordinateMap<std::shared_ptr<const BlockStore>> mGeneratedChunks;
+
+    /// @brief The jobs generating chunks, by the coordinates of the chunk.
+    CoordinateMap<JobSystem::JobHandle> mGenerations;
+
+    /// @brief The worker threads used to generate and mesh the chunks.
+    ///
+    /// This is declared before the mesh workers, which use it.
+    JobSystem mJobs;
 
     /// @brief The Shader Program used by this application.
     ShaderProgram mShaderProgram;
     GLuint mUniformVP;
     GLuint mUniformModel;
 
+    /// @brief The meshing of the chunks on the job system.
+    MeshWorkerPool mMeshWorkers;
+
     /// @brief The Camera Controller that gives life to the camera.
     CameraController mCameraController;
 
-    /// @brief Checks a chunk and it's neighbors for loading/unloading.
+    /// @brief Gets the projection used to render the region.
+    static glm::mat4 getProjection(void);
+
+    /// @brief Saves a chunk if its blocks differ from storage.
+    void saveChunk(glm::ivec3 coords, Chunk &chunk);
+
+    /// @brief Uploads the meshes that the workers have finished.
+    ///
+    /// Meshes are uploaded until the upload budget is spent. Meshes generated
+    /// from an outdated revision of a chunk, or for a chunk that has been
+    /// unloaded, are discarded.
+    void uploadMeshes(void);
+
+    /// @brief Sends the chunks on the mesh list to the workers.
+    ///
+    /// Chunks are captured until the meshing budget is spent. Chunks that are
+    /// already being meshed are queued again once their mesh is collected.
+    void submitMeshes(void);
+
+    /// @brief Fills the tables of offsets within the load and unload
+    /// distances.
+    void buildLoadOffsets(void);
+
+    /// @brief Fills a table with the offsets within a distance.
+    static void buildOffsets(unsigned int distance,
+        std::vector<LoadOffsetStruct> &offsets);
+
+    /// @brief Gets the first offset of a table that may be outside its sphere
+    /// after the center moves by a number of chunks.
+    ///
+    /// A chunk closer to the center than the distance minus the length of the
+    /// move is in both spheres, so only the offsets from the returned one
+    /// onwards need to be compared.
+    static std::vector<LoadOffsetStruct>::iterator findShell(
+        std::vector<LoadOffsetStruct> &offsets, unsigned int distance,
+        glm::ivec3 move);
+
+    /// @brief Changes the load distance.
+    ///
+    /// The chunks that are past the new unload distance are queued to be
+    /// unloaded, or the chunks that are newly within the load distance are
+    /// queued to be loaded.
+    void resizeLoadSphere(unsigned int distance);
+
+    /// @brief Keeps the memory used by the chunks within the budget.
+    ///
+    /// The memory is measured every tick. When it is over the budget, the
+    /// oldest cached chunks and the resident chunks outside the load sphere
+    /// are dropped first, and the load distance shrinks by the width of a
+    /// chunk if that is not enough. The distance only changes again once the
+    /// chunks queued by the previous change are done.
+    void governMemory(void);
+
+    /// @brief Evicts and restores meshes to stay within the video memory
+    /// budget.
+    void governMeshes(void);
+
+    /// @brief Updates the load and unload lists for the camera.
+    ///
+    /// The load set only changes when the camera moves into another chunk.
+    /// The chunks that entered the load sphere are queued to be loaded, and
+    /// the chunks that left the unload sphere are queued to be unloaded. Only
+    /// the offsets near the surface of the spheres can change, so the offsets
+    /// closer to the center are skipped.
+    void updateLoadSet(void);
+
+    /// @brief Chooses the level of detail of every loaded chunk.
     ///
-    /// This function is used to mark chunks for loading/unloading.
-    void updateChunkLists(std::pair<glm::ivec3, Chunk*> ci);
+    /// The levels only change when the camera moves into another chunk.
+    /// Chunks whose level changes are queued to be meshed again, along with
+    /// their neighbors, whose borders are meshed against the cells the chunk
+    /// draws.
+    void updateLods(void);
+
+    /// @brief Prefetches the chunks ahead of the camera.
+    ///
+    /// The camera's velocity predicts the chunk it will reach in a couple of
+    /// seconds. The saved chunks that will be in the load sphere around that
+    /// chunk, but are not in the current one, are read in the background so
+    /// they are resident by the time they are loaded. The prefetches are
+    /// replaced whenever the predicted chunk changes.
+    void prefetchChunks(void);
+
+    /// @brief Collects the chunks that the loader has read and the jobs have
+    /// generated.
+    ///
+    /// The blocks are interned until the generation budget is spent, and
+    /// chunks within the load distance are queued to be loaded. Once too many
+    /// chunks are resident or generated, those outside both the current and
+    /// the predicted load spheres are dropped.
+    void collectChunks(void);
+
+    /// @brief Drops the chunks of a map that the camera is no longer expected
+    /// to reach, once the map holds more than a limit.
+    ///
+    /// @returns The number of chunks dropped.
+    unsigned int dropStaleChunks(
+        CoordinateMap<std::shared_ptr<const BlockStore>> &chunks,
+        unsigned int limit);
+
+    /// @brief Generates a chunk on the job system.
+    ///
+    /// The blocks are filled by a worker, then interned on the main thread
+    /// when collectChunks runs the job's continuation, and the chunk is queued
+    /// to be loaded again if it is still within the load distance.
+    void generateChunk(glm::ivec3 coords);
+
+    /// @brief Determines if a chunk is within the load distance of a center.
+    bool isInLoadSphere(glm::ivec3 coords, glm::ivec3 center);
+
+    /// @brief Determines if a chunk is within the unload distance of a
+    /// center.
+    bool isInUnloadSphere(glm::ivec3 coords, glm::ivec3 center);
 
     /// @brief The load algorithm for chunk loading/unloading.
     ///
     /// This function represents the algorithm for loading or unloading a chunk.
     /// Given a chunk's coordinates, this function will return true if the
-    /// chunk should be loaded, or false if the chunk should be unloaded.
+    /// chunk should be loaded, or false if the chunk should be unloaded. The
+    /// distance is measured from the chunk containing the camera, so the
+    /// result only changes when the camera crosses into another chunk.
     bool chunkLoadAlgorithm(glm::ivec3 coords);
 
+    /// @brief The unload algorithm for chunk unloading.
+    ///
+    /// Given a chunk's coordinates, this function will return true if the
+    /// chunk should be unloaded. A chunk that has left the load distance is
+    /// kept until it is past the unload distance.
+    bool chunkUnloadAlgorithm(glm::ivec3 coords);
+
+    /// @brief The level of detail algorithm for chunk meshing.
+    ///
+    /// Given a chunk's coordinates and its current level of detail, this
+    /// function returns the level the chunk should be meshed at. A chunk moves
+    /// to a finer level as soon as it is within that level's distance, but
+    /// only moves to a coarser level once it is a margin past the distance,
+    /// so chunks near the boundary do not switch back and forth.
+    int chunkLodAlgorithm(glm::ivec3 coords, int current);
+
     /// @brief Loads chunks from the chunk load list.
     ///
     /// This function will load chunks from the list and insert them into the
-    /// chunk map.
+    /// chunk map until the generation budget is spent. Recently unloaded
+    /// chunks are revived from the cache along with their meshes. When chunks
+    /// are saved, a chunk that is not resident is requested from the loader
+    /// instead, and queued again once it has been read. Chunks that have never
+    /// been saved are generated on the job system, and likewise queued again
+    /// once they have been generated. Chunks that have left the load distance
+    /// since they were queued are skipped.
     void loadChunks(void);
 
     /// @brief Unloads chunks from the map.
     ///
     /// This function will unload chunks from the map based upon the chunk
-    /// remove list.
+    /// remove list until the generation budget is spent. Chunks that differ
+    /// from storage are saved first, and every unloaded chunk is added to the
+    /// cache. Chunks that have come back within the unload distance since they
+    /// were queued are kept.
     void unloadChunks(void);
 };
 
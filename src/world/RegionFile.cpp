@@ -0,0 +1,643 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file RegionFile.cpp
+/// @brief A file holding the saved blocks of a group of chunks.
+///
+/// This file contains the RegionFile class. Chunks are saved in groups of
+/// REGION_SIZE chunks along each axis, so a walk through the world opens a few
+/// files instead of one per chunk.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "BitOps.hpp"
+#include "RegionFile.hpp"
+
+// The bytes that start every region file.
+static const char MAGIC[4] = {'C', 'M', 'B', 'R'};
+
+// The version of the format, which is bumped whenever the layout changes.
+static const uint32_t VERSION = 2;
+
+// The ways that the palette indices of a payload can be stored.
+enum PayloadEncodingEnum
+{
+    RUN_LENGTH = 0,
+    PACKED = 1
+};
+
+static void putU16(std::vector<uint8_t> &out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+static void putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+static void putU64(uint8_t *out, uint64_t value)
+{
+    putU32(&out[0], static_cast<uint32_t>(value));
+    putU32(&out[4], static_cast<uint32_t>(value >> 32));
+}
+
+static uint32_t getU16(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) |
+        (static_cast<uint32_t>(data[1]) << 8);
+}
+
+static uint32_t getU32(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) |
+        (static_cast<uint32_t>(data[1]) << 8) |
+        (static_cast<uint32_t>(data[2]) << 16) |
+        (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static uint64_t getU64(const uint8_t *data)
+{
+    return static_cast<uint64_t>(getU32(&data[0])) |
+        (static_cast<uint64_t>(getU32(&data[4])) << 32);
+}
+
+// Appends a value with 7 bits per byte, setting the high bit of every byte
+// but the last.
+static void putVarint(std::vector<uint8_t> &out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Reads a value written by putVarint.
+//
+// Returns false if the value runs past the end of the data.
+static bool getVarint(const uint8_t *&data, const uint8_t *end,
+    uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (data == end)
+        {
+            return false;
+        }
+
+        uint8_t byte = *data++;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+RegionFile::RegionFile(const std::string &path)
+    : mPath(path), mEntries(REGION_CHUNK_COUNT, ChunkEntryStruct{0, 0})
+{
+    mOpen = false;
+    mFileSize = 0;
+    mMapping = nullptr;
+    mMappingSize = 0;
+
+    mFile.open(mPath, std::ios::in | std::ios::out | std::ios::binary);
+    if (!mFile.is_open() && !create())
+    {
+        std::cerr << "RegionFile::RegionFile Unable to open " << mPath
+            << std::endl;
+        return;
+    }
+
+    mFile.seekg(0, std::ios::end);
+    mFileSize = static_cast<uint64_t>(mFile.tellg());
+
+    if (!map() || !readHeader())
+    {
+        std::cerr << "RegionFile::RegionFile " << mPath
+            << " is not a region file of this version and chunk size"
+            << std::endl;
+        mFile.close();
+        unmap();
+        return;
+    }
+
+    mOpen = true;
+}
+
+RegionFile::~RegionFile(void)
+{
+    unmap();
+}
+
+bool RegionFile::isOpen(void)
+{
+    return mOpen;
+}
+
+bool RegionFile::load(glm::ivec3 local, BlockId *blocks, bool &uniform)
+{
+    if (!mOpen)
+    {
+        return false;
+    }
+
+    const ChunkEntryStruct &entry = mEntries[entryIndex(local)];
+    if (entry.length == 0)
+    {
+        return false;
+    }
+
+    // The file may have grown since it was mapped.
+    size_t end = static_cast<size_t>(entry.offset) + entry.length;
+    if ((end > mMappingSize) && !map())
+    {
+        return false;
+    }
+
+    if ((end > mMappingSize) ||
+        !decode(mMapping + entry.offset, entry.length, blocks, uniform))
+    {
+        std::cerr << "RegionFile::load A chunk of " << mPath
+            << " is corrupt" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool RegionFile::save(glm::ivec3 local, const std::vector<uint8_t> &payload)
+{
+    if (!mOpen)
+    {
+        return false;
+    }
+
+    // The payload goes to free space, so the previous payload stays intact
+    // until the table entry points away from it.
+    int index = entryIndex(local);
+    ChunkEntryStruct entry;
+    entry.length = static_cast<uint32_t>(payload.size());
+    entry.offset = allocate(entry.length);
+
+    uint8_t table[ENTRY_SIZE];
+    putU64(&table[0], entry.offset);
+    putU32(&table[8], entry.length);
+
+    mFile.seekp(entry.offset);
+    mFile.write(reinterpret_cast<const char *>(payload.data()),
+        payload.size());
+    mFile.flush();
+    if (mFile.good())
+    {
+        mFile.seekp(HEADER_SIZE + (index * ENTRY_SIZE));
+        mFile.write(reinterpret_cast<const char *>(table), ENTRY_SIZE);
+        mFile.flush();
+    }
+
+    if (!mFile.good())
+    {
+        std::cerr << "RegionFile::save Unable to write " << mPath
+            << std::endl;
+        mFile.clear();
+        release(entry.offset, entry.length);
+        return false;
+    }
+
+    release(mEntries[index].offset, mEntries[index].length);
+    mEntries[index] = entry;
+
+    return true;
+}
+
+glm::ivec3 RegionFile::chunkToRegionCoords(glm::ivec3 coords)
+{
+    // Round towards negative infinity, so that the chunks at -1 belong to the
+    // region at -1.
+    glm::ivec3 region;
+    for (int i = 0; i < 3; i++)
+    {
+        region[i] = (coords[i] >= 0)
+            ? (coords[i] / REGION_SIZE)
+            : -((-coords[i] - 1) / REGION_SIZE) - 1;
+    }
+
+    return region;
+}
+
+glm::ivec3 RegionFile::chunkToLocalCoords(glm::ivec3 coords)
+{
+    return coords - (chunkToRegionCoords(coords) * REGION_SIZE);
+}
+
+void RegionFile::encode(const BlockStore &blocks, std::vector<uint8_t> &out)
+{
+    BlockId types[Chunk::BLOCK_COUNT];
+    blocks.copyTo(types);
+
+    // Build the palette in the order that the types first occur, and replace
+    // each block by its index in the palette.
+    std::vector<BlockId> palette;
+    std::unordered_map<BlockId, uint32_t> lookup;
+    std::vector<uint32_t> indices(Chunk::BLOCK_COUNT);
+    BlockId previous = types[0];
+    uint32_t previousIndex = 0;
+    palette.push_back(previous);
+    lookup[previous] = 0;
+
+    for (int i = 0; i < Chunk::BLOCK_COUNT; i++)
+    {
+        if (types[i] != previous)
+        {
+            auto it = lookup.find(types[i]);
+            if (it == lookup.end())
+            {
+                it = lookup.insert({types[i], palette.size()}).first;
+                palette.push_back(types[i]);
+            }
+
+            previous = types[i];
+            previousIndex = it->second;
+        }
+
+        indices[i] = previousIndex;
+    }
+
+    // Run-length encode the indices, and keep the result if it is smaller
+    // than packing them.
+    std::vector<uint8_t> runs;
+    int start = 0;
+    for (int i = 1; i <= Chunk::BLOCK_COUNT; i++)
+    {
+        if ((i == Chunk::BLOCK_COUNT) || (indices[i] != indices[start]))
+        {
+            putVarint(runs, i - start);
+            putVarint(runs, indices[start]);
+            start = i;
+        }
+    }
+
+    int bits = bitWidth(palette.size() - 1);
+    size_t packedSize =
+        ((static_cast<size_t>(Chunk::BLOCK_COUNT) * bits) + 7) / 8;
+    bool packed = packedSize < runs.size();
+
+    out.push_back(packed ? PACKED : RUN_LENGTH);
+    putU16(out, palette.size() - 1);
+    for (BlockId type : palette)
+    {
+        putU16(out, type);
+    }
+
+    if (!packed)
+    {
+        out.insert(out.end(), runs.begin(), runs.end());
+        return;
+    }
+
+    // Pack the indices least significant bit first.
+    size_t base = out.size();
+    out.resize(base + packedSize, 0);
+    for (int i = 0; i < Chunk::BLOCK_COUNT; i++)
+    {
+        size_t bit = static_cast<size_t>(i) * bits;
+        for (int b = 0; b < bits; b++, bit++)
+        {
+            if ((indices[i] >> b) & 1)
+            {
+                out[base + (bit >> 3)] |= static_cast<uint8_t>(1 << (bit & 7));
+            }
+        }
+    }
+}
+
+bool RegionFile::decode(const uint8_t *data, size_t size, BlockId *blocks,
+    bool &uniform)
+{
+    const uint8_t *end = data + size;
+    if (size < 3)
+    {
+        return false;
+    }
+
+    uint32_t encoding = data[0];
+    uint32_t paletteSize = getU16(&data[1]) + 1;
+    data += 3;
+
+    if (static_cast<size_t>(end - data) < paletteSize * 2)
+    {
+        return false;
+    }
+
+    std::vector<BlockId> palette(paletteSize);
+    for (uint32_t i = 0; i < paletteSize; i++)
+    {
+        palette[i] = static_cast<BlockId>(getU16(data));
+        data += 2;
+    }
+
+    // A single type needs no indices.
+    uniform = (paletteSize == 1);
+    if (uniform)
+    {
+        blocks[0] = palette[0];
+        return true;
+    }
+
+    if (encoding == RUN_LENGTH)
+    {
+        int i = 0;
+        while (i < Chunk::BLOCK_COUNT)
+        {
+            uint32_t length, index;
+            if (!getVarint(data, end, length) ||
+                !getVarint(data, end, index) ||
+                (length == 0) ||
+                (length > static_cast<uint32_t>(Chunk::BLOCK_COUNT - i)) ||
+                (index >= paletteSize))
+            {
+                return false;
+            }
+
+            for (uint32_t j = 0; j < length; j++)
+            {
+                blocks[i++] = palette[index];
+            }
+        }
+    }
+    else if (encoding == PACKED)
+    {
+        int bits = bitWidth(paletteSize - 1);
+        size_t packedSize = ((static_cast<size_t>(Chunk::BLOCK_COUNT) * bits)
+            + 7) / 8;
+        if (static_cast<size_t>(end - data) < packedSize)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < Chunk::BLOCK_COUNT; i++)
+        {
+            size_t bit = static_cast<size_t>(i) * bits;
+            uint32_t index = 0;
+            for (int b = 0; b < bits; b++, bit++)
+            {
+                index |= ((data[bit >> 3] >> (bit & 7)) & 1u) << b;
+            }
+
+            if (index >= paletteSize)
+            {
+                return false;
+            }
+
+            blocks[i] = palette[index];
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool RegionFile::create(void)
+{
+    std::vector<uint8_t> header(PAYLOAD_OFFSET, 0);
+    std::memcpy(&header[0], MAGIC, sizeof(MAGIC));
+    putU32(&header[4], VERSION);
+    putU32(&header[8], REGION_SIZE);
+    putU32(&header[12], Chunk::CHUNK_SIZE_X);
+    putU32(&header[16], Chunk::CHUNK_SIZE_Y);
+    putU32(&header[20], Chunk::CHUNK_SIZE_Z);
+
+    std::ofstream file(mPath, std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char *>(header.data()),
+        header.size());
+    file.close();
+    if (!file.good())
+    {
+        return false;
+    }
+
+    mFile.open(mPath, std::ios::in | std::ios::out | std::ios::binary);
+    return mFile.is_open();
+}
+
+bool RegionFile::readHeader(void)
+{
+    if ((mMappingSize < PAYLOAD_OFFSET) ||
+        (std::memcmp(mMapping, MAGIC, sizeof(MAGIC)) != 0) ||
+        (getU32(&mMapping[4]) != VERSION) ||
+        (getU32(&mMapping[8]) != REGION_SIZE) ||
+        (getU32(&mMapping[12]) != Chunk::CHUNK_SIZE_X) ||
+        (getU32(&mMapping[16]) != Chunk::CHUNK_SIZE_Y) ||
+        (getU32(&mMapping[20]) != Chunk::CHUNK_SIZE_Z))
+    {
+        return false;
+    }
+
+    const uint8_t *table = mMapping + HEADER_SIZE;
+    std::vector<ChunkEntryStruct> payloads;
+    for (int i = 0; i < REGION_CHUNK_COUNT; i++)
+    {
+        mEntries[i].offset = getU64(&table[i * ENTRY_SIZE]);
+        mEntries[i].length = getU32(&table[(i * ENTRY_SIZE) + 8]);
+
+        if (mEntries[i].length > 0)
+        {
+            payloads.push_back(mEntries[i]);
+        }
+    }
+
+    // Everything between the table and the end of the file that no payload
+    // covers is free.
+    std::sort(payloads.begin(), payloads.end(),
+        [](const ChunkEntryStruct &a, const ChunkEntryStruct &b) {
+            return a.offset < b.offset;
+        });
+
+    mFreeExtents.clear();
+    uint64_t cursor = PAYLOAD_OFFSET;
+    for (const ChunkEntryStruct &payload : payloads)
+    {
+        if (payload.offset > cursor)
+        {
+            mFreeExtents[cursor] = payload.offset - cursor;
+        }
+
+        cursor = std::max(cursor, payload.offset + payload.length);
+    }
+
+    if (mFileSize > cursor)
+    {
+        mFreeExtents[cursor] = mFileSize - cursor;
+    }
+
+    return true;
+}
+
+uint64_t RegionFile::allocate(uint32_t length)
+{
+    for (std::map<uint64_t, uint64_t>::iterator it = mFreeExtents.begin();
+        it != mFreeExtents.end(); ++it)
+    {
+        uint64_t offset = it->first;
+        uint64_t extent = it->second;
+
+        // A free extent at the end of the file can be extended.
+        bool last = (offset + extent) == mFileSize;
+        if ((extent < length) && !last)
+        {
+            continue;
+        }
+
+        mFreeExtents.erase(it);
+        if (extent > length)
+        {
+            mFreeExtents[offset + length] = extent - length;
+        }
+        else if (last)
+        {
+            mFileSize = offset + length;
+        }
+
+        return offset;
+    }
+
+    uint64_t offset = mFileSize;
+    mFileSize += length;
+
+    return offset;
+}
+
+void RegionFile::release(uint64_t offset, uint32_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+
+    uint64_t end = offset + length;
+
+    // Merge with the extent that follows.
+    std::map<uint64_t, uint64_t>::iterator next = mFreeExtents.find(end);
+    if (next != mFreeExtents.end())
+    {
+        end += next->second;
+        mFreeExtents.erase(next);
+    }
+
+    // Merge with the extent that precedes.
+    std::map<uint64_t, uint64_t>::iterator it =
+        mFreeExtents.lower_bound(offset);
+    if (it != mFreeExtents.begin())
+    {
+        --it;
+        if ((it->first + it->second) == offset)
+        {
+            offset = it->first;
+            mFreeExtents.erase(it);
+        }
+    }
+
+    mFreeExtents[offset] = end - offset;
+}
+
+bool RegionFile::map(void)
+{
+    unmap();
+
+    if (mFileSize == 0)
+    {
+        return false;
+    }
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(mPath.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY,
+        static_cast<DWORD>(mFileSize >> 32), static_cast<DWORD>(mFileSize),
+        NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        return false;
+    }
+
+    // The view keeps the mapping alive after its handle is closed.
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0,
+        static_cast<SIZE_T>(mFileSize));
+    CloseHandle(mapping);
+    if (view == NULL)
+    {
+        return false;
+    }
+#else
+    int file = open(mPath.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    void *view = mmap(nullptr, static_cast<size_t>(mFileSize), PROT_READ,
+        MAP_SHARED, file, 0);
+    close(file);
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+#endif
+
+    mMapping = static_cast<const uint8_t *>(view);
+    mMappingSize = mFileSize;
+
+    return true;
+}
+
+void RegionFile::unmap(void)
+{
+    if (mMapping == nullptr)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mMapping);
+#else
+    munmap(const_cast<uint8_t *>(mMapping), mMappingSize);
+#endif
+
+    mMapping = nullptr;
+    mMappingSize = 0;
+}
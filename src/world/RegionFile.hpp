@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file RegionFile.hpp
+/// @brief A file holding the saved blocks of a group of chunks.
+///
+/// This file contains the RegionFile class. Chunks are saved in groups of
+/// REGION_SIZE chunks along each axis, so a walk through the world opens a few
+/// files instead of one per chunk.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_REGION_FILE_H_
+#define _CAMBRE_REGION_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Block.hpp"
+#include "BlockStore.hpp"
+#include "Chunk.hpp"
+
+/// @class RegionFile
+/// @brief A file holding the saved blocks of a group of chunks.
+///
+/// A region file starts with a header that identifies the format and the size
+/// of a chunk, followed by a table with the offset and length of the payload
+/// of each chunk. A length of zero marks a chunk that has not been saved. All
+/// values are stored little endian.
+///
+/// A payload holds the palette of the chunk's blocks followed by the palette
+/// indices of the blocks in [x][y][z] order, either run-length encoded or
+/// packed into the fewest bits that fit the palette, whichever is smaller.
+///
+/// A saved payload never overwrites the payload it replaces. It is written to
+/// free space first, and only then does the table entry switch to it, so a
+/// crash during a save leaves the previous payload intact. The space of the
+/// replaced payload is then free for later saves. The free space is found
+/// from the gaps between the payloads in the table when the file is opened,
+/// so the file only grows when no gap fits a payload.
+///
+/// The file is memory mapped for reading, so chunks are decoded straight from
+/// the page cache without an intermediate copy. Writes go through a regular
+/// stream, and the mapping is extended once it no longer covers the file.
+///
+/// Loading and saving do not touch any shared state, so a region file can be
+/// used on a background thread, as long as one thread uses it at a time.
+/// Encoding reads a BlockStore and therefore stays on the main thread.
+class RegionFile
+{
+public:
+    /// @brief The number of chunks in a region along each axis.
+    static const int REGION_SIZE = 32;
+
+    /// @brief The number of chunks in a region.
+    static const int REGION_CHUNK_COUNT =
+        REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+    /// @brief Opens the region file at a path.
+    ///
+    /// The file is created if it does not exist. A file that cannot be
+    /// opened, or that was written for a different chunk size, is reported
+    /// and left untouched; loads from it miss and saves to it are dropped.
+    RegionFile(const std::string &path);
+
+    /// @brief The default destructor.
+    ///
+    /// Unmaps and closes the file.
+    ~RegionFile(void);
+
+    RegionFile(const RegionFile &) = delete;
+    RegionFile &operator=(const RegionFile &) = delete;
+
+    /// @brief Determines if the file could be opened.
+    bool isOpen(void);
+
+    /// @brief Reads the blocks of a chunk.
+    ///
+    /// The coordinates are local to the region. The blocks are decoded as
+    /// described by decode.
+    ///
+    /// @returns False if the chunk has not been saved or its payload is
+    /// corrupt.
+    bool load(glm::ivec3 local, BlockId *blocks, bool &uniform);
+
+    /// @brief Writes the payload of a chunk.
+    ///
+    /// The coordinates are local to the region, and the payload is made by
+    /// encode.
+    ///
+    /// @returns True if the chunk was written.
+    bool save(glm::ivec3 local, const std::vector<uint8_t> &payload);
+
+    /// @brief Gets the coordinates of the region containing a chunk.
+    static glm::ivec3 chunkToRegionCoords(glm::ivec3 coords);
+
+    /// @brief Gets the coordinates of a chunk within its region.
+    static glm::ivec3 chunkToLocalCoords(glm::ivec3 coords);
+
+    /// @brief Encodes the blocks of a chunk into a payload.
+    ///
+    /// The payload is appended to the output.
+    static void encode(const BlockStore &blocks, std::vector<uint8_t> &out);
+
+    /// @brief Decodes a payload into the blocks of a chunk.
+    ///
+    /// The blocks are Chunk::BLOCK_COUNT types indexed by [x][y][z]. When
+    /// every block has the same type, uniform is set and only the first block
+    /// is written.
+    ///
+    /// @returns False if the payload is corrupt.
+    static bool decode(const uint8_t *data, size_t size, BlockId *blocks,
+        bool &uniform);
+
+private:
+    /// @brief A struct containing the location of a chunk's payload.
+    struct ChunkEntryStruct
+    {
+        uint64_t offset;
+        uint32_t length;
+    };
+
+    /// @brief The number of bytes before the offset table.
+    static const uint32_t HEADER_SIZE = 24;
+
+    /// @brief The number of bytes in each entry of the offset table: a 64 bit
+    /// offset and a 32 bit length.
+    static const uint32_t ENTRY_SIZE = 12;
+
+    /// @brief The offset of the first payload.
+    static const uint32_t PAYLOAD_OFFSET =
+        HEADER_SIZE + (REGION_CHUNK_COUNT * ENTRY_SIZE);
+
+    /// @brief Gets the index of a chunk in the offset table.
+    static int entryIndex(glm::ivec3 local)
+    {
+        return (((local.x * REGION_SIZE) + local.y) * REGION_SIZE) + local.z;
+    }
+
+    /// @brief Writes a new file with an empty offset table.
+    bool create(void);
+
+    /// @brief Reads and checks the header and the offset table.
+    ///
+    /// The gaps between the payloads are recorded as free space.
+    bool readHeader(void);
+
+    /// @brief Finds space for a payload of a length.
+    ///
+    /// The first free extent that fits is used, and the file is extended
+    /// otherwise.
+    ///
+    /// @returns The offset of the space.
+    uint64_t allocate(uint32_t length);
+
+    /// @brief Marks the space of a payload as free, merging it with the free
+    /// extents next to it.
+    void release(uint64_t offset, uint32_t length);
+
+    /// @brief Maps the whole file into memory.
+    ///
+    /// Any previous mapping is released first.
+    bool map(void);
+
+    /// @brief Releases the mapping of the file.
+    void unmap(void);
+
+    /// @brief The path of the file.
+    std::string mPath;
+
+    /// @brief The stream used to write the file.
+    std::fstream mFile;
+
+    /// @brief A flag indicating the file is usable.
+    bool mOpen;
+
+    /// @brief The location of each chunk's payload.
+    std::vector<ChunkEntryStruct> mEntries;
+
+    /// @brief The number of bytes in the file.
+    uint64_t mFileSize;
+
+    /// @brief The length of each free extent of the file, by its offset.
+    std::map<uint64_t, uint64_t> mFreeExtents;
+
+    /// @brief The mapped contents of the file.
+    const uint8_t *mMapping;
+
+    /// @brief The number of bytes that are mapped.
+    size_t mMappingSize;
+};
+
+#endif
@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file StreamingBudget.cpp
+/// @brief Per-tick time budgets for streaming chunks.
+///
+/// This file contains the StreamingBudget class. It limits the time that each
+/// stage of chunk streaming may spend on the main thread during a tick, and
+/// keeps statistics about the work that is left over for later ticks.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "StreamingBudget.hpp"
+
+// The names of each stage, indexed by StageEnum.
+static const char *STAGE_NAMES[StreamingBudget::MAX_STAGE] = {
+    "Generation",
+    "Meshing",
+    "Upload"
+};
+
+// The default budget of each stage in milliseconds, indexed by StageEnum.
+static const double DEFAULT_BUDGETS[StreamingBudget::MAX_STAGE] = {
+    4.0,
+    2.0,
+    2.0
+};
+
+StreamingBudget::StreamingBudget(void)
+{
+    for (int stage = 0; stage < MAX_STAGE; stage++)
+    {
+        mBudget[stage] = DEFAULT_BUDGETS[stage] / 1000.0;
+        mItemCost[stage] = 0.0;
+        mStatistics[stage] = {0, 0, 0, 0.0, 0, 0, 0};
+    }
+
+    mStage = GENERATION;
+    mSpent = 0.0;
+    mItems = 0;
+}
+
+void StreamingBudget::setBudget(StageEnum stage, double milliseconds)
+{
+    mBudget[stage] = milliseconds / 1000.0;
+}
+
+double StreamingBudget::getBudget(StageEnum stage)
+{
+    return mBudget[stage] * 1000.0;
+}
+
+void StreamingBudget::begin(StageEnum stage)
+{
+    mStage = stage;
+    mSpent = 0.0;
+    mItems = 0;
+}
+
+bool StreamingBudget::hasTime(void)
+{
+    // Always allow one item, so that a stage whose items cost more than its
+    // budget still makes progress.
+    if (mItems == 0)
+    {
+        return true;
+    }
+
+    return (mSpent + mItemCost[mStage]) <= mBudget[mStage];
+}
+
+void StreamingBudget::startItem(void)
+{
+    mItemStart = Clock::now();
+}
+
+void StreamingBudget::complete(void)
+{
+    double cost = elapsed(mItemStart);
+    mSpent += cost;
+    mItems++;
+
+    // Track the cost of an item with an exponential moving average, so that
+    // the estimate follows changes in the content being streamed.
+    if (mItemCost[mStage] == 0.0)
+    {
+        mItemCost[mStage] = cost;
+    }
+    else
+    {
+        mItemCost[mStage] += COST_SMOOTHING * (cost - mItemCost[mStage]);
+    }
+}
+
+void StreamingBudget::end(unsigned int backlog)
+{
+    StageStatisticsStruct &stats = mStatistics[mStage];
+    stats.ticks++;
+    stats.items += mItems;
+    stats.seconds += mSpent;
+    stats.backlog = backlog;
+    stats.totalBacklog += backlog;
+
+    if (backlog > stats.maxBacklog)
+    {
+        stats.maxBacklog = backlog;
+    }
+
+    if (mSpent > mBudget[mStage])
+    {
+        stats.overruns++;
+    }
+}
+
+StreamingBudget::StageStatisticsStruct StreamingBudget::getStatistics(
+    StageEnum stage)
+{
+    return mStatistics[stage];
+}
+
+void StreamingBudget::printStatistics(void)
+{
+    for (int stage = 0; stage < MAX_STAGE; stage++)
+    {
+        const StageStatisticsStruct &stats = mStatistics[stage];
+        if (stats.ticks == 0)
+        {
+            continue;
+        }
+
+        std::cout << STAGE_NAMES[stage] << " Streaming: "
+            << stats.items << " items in " << stats.ticks << " ticks, "
+            << stats.seconds * 1000.0 / stats.ticks << " ms per tick of "
+            << mBudget[stage] * 1000.0 << " ms, "
+            << stats.overruns << " overruns, backlog "
+            << stats.backlog << " (average "
+            << stats.totalBacklog / stats.ticks << ", max "
+            << stats.maxBacklog << ")" << std::endl;
+    }
+}
+
+double StreamingBudget::elapsed(Clock::time_point start)
+{
+    std::chrono::duration<double> seconds = Clock::now() - start;
+    return seconds.count();
+}
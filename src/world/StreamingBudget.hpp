@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file StreamingBudget.hpp
+/// @brief Per-tick time budgets for streaming chunks.
+///
+/// This file contains the StreamingBudget class. It limits the time that each
+/// stage of chunk streaming may spend on the main thread during a tick, and
+/// keeps statistics about the work that is left over for later ticks.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_STREAMING_BUDGET_H_
+#define _CAMBRE_STREAMING_BUDGET_H_
+
+#include <chrono>
+
+/// @class StreamingBudget
+/// @brief Per-tick time budgets for streaming chunks.
+///
+/// Each stage of streaming is given a number of milliseconds per tick. The time
+/// spent on each item of a stage is measured between startItem and complete,
+/// and a stage keeps taking items while hasTime returns true, which happens
+/// while the time spent so far plus the average cost of an item fits in the
+/// budget. At least one item is processed per tick so that slow machines still
+/// make progress. A fast machine finishes more items within the same budget,
+/// so a backlog is cleared in fewer ticks.
+class StreamingBudget
+{
+public:
+    /// @brief An enum representing the stages of chunk streaming.
+    ///
+    /// The generation stage loads chunks, which generates their blocks, and
+    /// unloads chunks. The meshing stage captures chunks for the mesh
+    /// workers. The upload stage sends finished meshes to the GPU.
+    enum StageEnum
+    {
+        GENERATION = 0,
+        MESHING,
+        UPLOAD,
+        MAX_STAGE
+    };
+
+    /// @brief A struct containing the statistics of a stage.
+    ///
+    /// The backlog is the number of items left over at the end of a tick.
+    struct StageStatisticsStruct
+    {
+        unsigned long ticks;
+        unsigned long items;
+        unsigned long overruns;
+        double seconds;
+        unsigned int backlog;
+        unsigned int maxBacklog;
+        unsigned long totalBacklog;
+    };
+
+    /// @brief The default constructor.
+    ///
+    /// Sets the default budget of each stage, which together leave most of a
+    /// 60 Hz frame for rendering.
+    StreamingBudget(void);
+
+    /// @brief Sets the time a stage may spend per tick, in milliseconds.
+    void setBudget(StageEnum stage, double milliseconds);
+
+    /// @brief Gets the time a stage may spend per tick, in milliseconds.
+    double getBudget(StageEnum stage);
+
+    /// @brief Starts timing a stage for the current tick.
+    void begin(StageEnum stage);
+
+    /// @brief Determines if the current stage has time for another item.
+    bool hasTime(void);
+
+    /// @brief Starts timing an item of the current stage.
+    void startItem(void);
+
+    /// @brief Records that the current stage has finished an item.
+    void complete(void);
+
+    /// @brief Stops timing the current stage.
+    ///
+    /// The backlog is the number of items that the stage has left over.
+    void end(unsigned int backlog);
+
+    /// @brief Gets the statistics of a stage.
+    StageStatisticsStruct getStatistics(StageEnum stage);
+
+    /// @brief Prints the statistics of every stage.
+    void printStatistics(void);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /// @brief The weight of the latest item in the average cost of an item.
+    static constexpr double COST_SMOOTHING = 0.125;
+
+    /// @brief Gets the seconds elapsed since a time point.
+    static double elapsed(Clock::time_point start);
+
+    /// @brief The budget of each stage, in seconds.
+    double mBudget[MAX_STAGE];
+
+    /// @brief The measured average cost of an item of each stage, in seconds.
+    double mItemCost[MAX_STAGE];
+
+    /// @brief The statistics of each stage.
+    StageStatisticsStruct mStatistics[MAX_STAGE];
+
+    /// @brief The stage being timed.
+    StageEnum mStage;
+
+    /// @brief The time the current item started.
+    Clock::time_point mItemStart;
+
+    /// @brief The time the current stage has spent this tick, in seconds.
+    double mSpent;
+
+    /// @brief The number of items the current stage has finished this tick.
+    unsigned int mItems;
+};
+
+#endif
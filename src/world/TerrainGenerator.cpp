@@ -0,0 +1,296 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file TerrainGenerator.cpp
+/// @brief A generator of noise based terrain.
+///
+/// This file contains the TerrainGenerator class. It shapes the surface of the
+/// world with a heightmap of two dimensional noise, fills the low ground with
+/// water, and carves caves out of the stone with three dimensional noise.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "TerrainGenerator.hpp"
+
+// The terrain used when no settings are given: rolling hills around the sea
+// level with caves a few blocks under the surface.
+static const TerrainGenerator::TerrainSettingsStruct DEFAULT_SETTINGS = {
+    1337,   // seed
+    0,      // seaLevel
+    4.0f,   // surfaceHeight
+    32.0f,  // surfaceAmplitude
+    128.0f, // surfaceScale
+    5,      // surfaceOctaves
+    32.0f,  // caveScale
+    0.3f,   // caveThreshold
+    2,      // caveOctaves
+    6       // caveRoof
+};
+
+// The amount the seed of the cave noise differs from the surface noise.
+static const uint32_t CAVE_SEED_OFFSET = 0x5BD1E995;
+
+// The largest cave lattice of a chunk. A lattice starting just before the
+// chunk spans one more sample than the chunk needs along each axis.
+static const int CAVE_SAMPLE_COUNT =
+    ((Chunk::CHUNK_SIZE_X - 1) / TerrainGenerator::CAVE_SAMPLE_SPACING + 2) *
+    ((Chunk::CHUNK_SIZE_Y - 1) / TerrainGenerator::CAVE_SAMPLE_SPACING + 2) *
+    ((Chunk::CHUNK_SIZE_Z - 1) / TerrainGenerator::CAVE_SAMPLE_SPACING + 2);
+
+// The number of samples held by the sample buffers, enough for the surface of
+// a column or the cave lattice of a chunk.
+static const int SAMPLE_CAPACITY =
+    (Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Z > CAVE_SAMPLE_COUNT)
+    ? Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Z : CAVE_SAMPLE_COUNT;
+
+// The positions sampled by the noise and the results, and the index into the
+// blocks of the stone that may be carved. Each thread generating chunks keeps
+// its own, to avoid allocating them for every chunk.
+struct ScratchStruct
+{
+    float sampleX[SAMPLE_CAPACITY];
+    float sampleY[SAMPLE_CAPACITY];
+    float sampleZ[SAMPLE_CAPACITY];
+    float samples[SAMPLE_CAPACITY];
+    int caveBlocks[Chunk::BLOCK_COUNT];
+};
+
+static thread_local ScratchStruct tScratch;
+
+// Divides, rounding towards negative infinity.
+static int floorDivide(int a, int b)
+{
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+static float lerp(float a, float b, float t)
+{
+    return a + t * (b - a);
+}
+
+TerrainGenerator::TerrainGenerator(void)
+    : TerrainGenerator(DEFAULT_SETTINGS)
+{
+}
+
+TerrainGenerator::TerrainGenerator(const TerrainSettingsStruct &settings)
+    : mSettings(settings),
+      mSurfaceNoise(settings.seed),
+      mCaveNoise(settings.seed + CAVE_SEED_OFFSET),
+      mColumns(COLUMN_CACHE_CAPACITY)
+{
+    mNextColumn = 0;
+    mChunks = 0;
+    mUniformChunks = 0;
+    mColumnHits = 0;
+    mColumnMisses = 0;
+    mCaveSamples = 0;
+    mTime = 0;
+}
+
+bool TerrainGenerator::generate(glm::ivec3 coords, BlockId *blocks)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    mChunks++;
+
+    ColumnStruct column;
+    getColumn(coords.x, coords.z, column);
+    int bottom = coords.y * Chunk::CHUNK_SIZE_Y;
+    int top = bottom + Chunk::CHUNK_SIZE_Y - 1;
+
+    // Chunks above the surface and the sea are empty, and chunks between the
+    // surface and the sea are full of water. Most of the chunks in view are
+    // one or the other.
+    if ((bottom > column.maxHeight) &&
+        ((bottom >= mSettings.seaLevel) || (top < mSettings.seaLevel)))
+    {
+        blocks[0] = (top < mSettings.seaLevel) ? Block::WATER : Block::AIR;
+        mUniformChunks++;
+        mTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    // Fill the chunk, and find the stone under the cave roof that may be
+    // carved.
+    int *caveBlocks = tScratch.caveBlocks;
+    int caveCount = 0;
+    BlockId *block = blocks;
+
+    for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++)
+    {
+        for (int y = 0; y < Chunk::CHUNK_SIZE_Y; y++)
+        {
+            int worldY = bottom + y;
+            for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++)
+            {
+                int height = column.heights[x * Chunk::CHUNK_SIZE_Z + z];
+                if (worldY > height)
+                {
+                    *block++ = (worldY < mSettings.seaLevel)
+                        ? Block::WATER : Block::AIR;
+                    continue;
+                }
+
+                *block++ = Block::STONE;
+                if (worldY <= height - mSettings.caveRoof)
+                {
+                    caveBlocks[caveCount++] =
+                        (x * Chunk::CHUNK_SIZE_Y + y) * Chunk::CHUNK_SIZE_Z + z;
+                }
+            }
+        }
+    }
+
+    if (caveCount > 0)
+    {
+        carveCaves(coords, blocks, caveBlocks, caveCount);
+    }
+
+    mTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return false;
+}
+
+void TerrainGenerator::printStatistics(void)
+{
+    double perChunk = (mChunks == 0) ? 0.0 : mTime * 1e-3 / mChunks;
+
+    std::cout << "Terrain: " << mChunks << " chunks (" << mUniformChunks
+        << " uniform), " << perChunk << " us per chunk, " << mCaveSamples
+        << " cave samples (" << Noise::LANES << " at once), column cache "
+        << mColumnHits << " hits, " << mColumnMisses << " misses"
+        << std::endl;
+}
+
+void TerrainGenerator::carveCaves(glm::ivec3 coords, BlockId *blocks,
+    const int *caveBlocks, int count)
+{
+    ScratchStruct &scratch = tScratch;
+
+    // The lattice covers the chunk, from the sample at or before its first
+    // block to the sample at or after its last block.
+    const int spacing = CAVE_SAMPLE_SPACING;
+    glm::ivec3 origin = coords * Chunk::getChunkSize();
+    glm::ivec3 last = origin + Chunk::getChunkSize() - glm::ivec3(1);
+    glm::ivec3 first(floorDivide(origin.x, spacing),
+        floorDivide(origin.y, spacing), floorDivide(origin.z, spacing));
+    glm::ivec3 size = glm::ivec3(floorDivide(last.x, spacing),
+        floorDivide(last.y, spacing), floorDivide(last.z, spacing)) -
+        first + glm::ivec3(2);
+
+    // Sample the whole lattice at once.
+    float frequency = spacing / mSettings.caveScale;
+    int samples = 0;
+    for (int i = 0; i < size.x; i++)
+    {
+        for (int j = 0; j < size.y; j++)
+        {
+            for (int k = 0; k < size.z; k++)
+            {
+                scratch.sampleX[samples] = (first.x + i) * frequency;
+                scratch.sampleY[samples] = (first.y + j) * frequency;
+                scratch.sampleZ[samples] = (first.z + k) * frequency;
+                samples++;
+            }
+        }
+    }
+    mCaveNoise.sample3D(scratch.sampleX, scratch.sampleY, scratch.sampleZ,
+        scratch.samples, samples, mSettings.caveOctaves);
+    mCaveSamples += samples;
+
+    // Interpolate the eight samples around each block.
+    glm::ivec3 offset = origin - first * spacing;
+    const int strideX = size.y * size.z;
+    const int strideY = size.z;
+    const float step = 1.0f / spacing;
+
+    for (int n = 0; n < count; n++)
+    {
+        int b = caveBlocks[n];
+        glm::ivec3 p = offset + glm::ivec3(
+            b / (Chunk::CHUNK_SIZE_Y * Chunk::CHUNK_SIZE_Z),
+            (b / Chunk::CHUNK_SIZE_Z) % Chunk::CHUNK_SIZE_Y,
+            b % Chunk::CHUNK_SIZE_Z);
+        glm::ivec3 cell = p / spacing;
+        glm::vec3 t = glm::vec3(p - cell * spacing) * step;
+
+        const float *c = &scratch.samples[cell.x * strideX +
+            cell.y * strideY + cell.z];
+        float y0 = lerp(lerp(c[0], c[strideX], t.x),
+            lerp(c[strideY], c[strideX + strideY], t.x), t.y);
+        float y1 = lerp(lerp(c[1], c[strideX + 1], t.x),
+            lerp(c[strideY + 1], c[strideX + strideY + 1], t.x), t.y);
+
+        if (lerp(y0, y1, t.z) > mSettings.caveThreshold)
+        {
+            blocks[b] = Block::AIR;
+        }
+    }
+}
+
+void TerrainGenerator::getColumn(int x, int z, ColumnStruct &column)
+{
+    glm::ivec3 coords(x, 0, z);
+    {
+        std::lock_guard<std::mutex> lock(mColumnMutex);
+        unsigned int *slot = mColumnIndex.find(coords);
+        if (slot != nullptr)
+        {
+            mColumnHits++;
+            column = mColumns[*slot];
+            return;
+        }
+    }
+    mColumnMisses++;
+
+    // Sample the surface of every column of blocks at once, outside the lock
+    // so that other threads can use the cache meanwhile.
+    ScratchStruct &scratch = tScratch;
+    float frequency = 1.0f / mSettings.surfaceScale;
+    for (int bx = 0; bx < Chunk::CHUNK_SIZE_X; bx++)
+    {
+        for (int bz = 0; bz < Chunk::CHUNK_SIZE_Z; bz++)
+        {
+            int i = bx * Chunk::CHUNK_SIZE_Z + bz;
+            scratch.sampleX[i] = (x * Chunk::CHUNK_SIZE_X + bx) * frequency;
+            scratch.sampleZ[i] = (z * Chunk::CHUNK_SIZE_Z + bz) * frequency;
+        }
+    }
+    mSurfaceNoise.sample2D(scratch.sampleX, scratch.sampleZ, scratch.samples,
+        COLUMN_COUNT, mSettings.surfaceOctaves);
+
+    column.coords = coords;
+    for (int i = 0; i < COLUMN_COUNT; i++)
+    {
+        int height = static_cast<int>(std::floor(mSettings.surfaceHeight +
+            mSettings.surfaceAmplitude * scratch.samples[i]));
+        column.heights[i] = height;
+
+        if ((i == 0) || (height > column.maxHeight))
+        {
+            column.maxHeight = height;
+        }
+    }
+
+    // Another thread may have added the column while it was computed.
+    std::lock_guard<std::mutex> lock(mColumnMutex);
+    if (mColumnIndex.find(coords) != nullptr)
+    {
+        return;
+    }
+
+    // The slots are filled in order, so once the cache is full the next slot
+    // holds the oldest column.
+    unsigned int next = mNextColumn;
+    mNextColumn = (mNextColumn + 1) % COLUMN_CACHE_CAPACITY;
+    if (mColumnIndex.size() == COLUMN_CACHE_CAPACITY)
+    {
+        mColumnIndex.erase(mColumns[next].coords);
+    }
+
+    mColumns[next] = column;
+    mColumnIndex.insert(coords, next);
+}
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file TerrainGenerator.hpp
+/// @brief A generator of noise based terrain.
+///
+/// This file contains the TerrainGenerator class. It shapes the surface of the
+/// world with a heightmap of two dimensional noise, fills the low ground with
+/// water, and carves caves out of the stone with three dimensional noise.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_TERRAIN_GENERATOR_H_
+#define _CAMBRE_TERRAIN_GENERATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Chunk.hpp"
+#include "ChunkGenerator.hpp"
+#include "CoordinateMap.hpp"
+#include "Noise.hpp"
+
+/// @class TerrainGenerator
+/// @brief A generator of noise based terrain.
+///
+/// The surface height of each column of blocks is computed once for all of
+/// the chunks stacked on it and kept in a cache of columns, so the heightmap
+/// is sampled once per column instead of once per chunk. Chunks entirely
+/// above the surface are filled with air or water without touching their
+/// blocks. The cave noise is only sampled on a lattice every
+/// CAVE_SAMPLE_SPACING blocks, in one batch per chunk, and interpolated for
+/// the stone under the cave roof. The lattice is aligned to the world rather
+/// than the chunk, so caves line up across chunk borders.
+///
+/// Chunks may be generated on several threads at once. The column cache is
+/// shared between them behind a lock, and each thread keeps its own buffers
+/// of samples.
+class TerrainGenerator : public ChunkGenerator
+{
+public:
+    /// @brief A struct containing the shape of the terrain.
+    ///
+    /// Heights are in blocks. The surface varies by up to the amplitude around
+    /// its height, with features about scale blocks across. Blocks above the
+    /// surface and below the sea level are water. Stone is carved out where
+    /// the cave noise, with features about caveScale blocks across, is above
+    /// the threshold, except within caveRoof blocks of the surface.
+    struct TerrainSettingsStruct
+    {
+        uint32_t seed;
+        int seaLevel;
+        float surfaceHeight;
+        float surfaceAmplitude;
+        float surfaceScale;
+        int surfaceOctaves;
+        float caveScale;
+        float caveThreshold;
+        int caveOctaves;
+        int caveRoof;
+    };
+
+    /// @brief The number of columns kept in the cache.
+    static const unsigned int COLUMN_CACHE_CAPACITY = 1024;
+
+    /// @brief The distance between the samples of the cave noise, in blocks.
+    static const int CAVE_SAMPLE_SPACING = 4;
+
+    /// @brief Constructs a generator with the default terrain.
+    TerrainGenerator(void);
+
+    /// @brief Constructs a generator with the terrain settings.
+    TerrainGenerator(const TerrainSettingsStruct &settings);
+
+    bool generate(glm::ivec3 coords, BlockId *blocks);
+    void printStatistics(void);
+
+private:
+    /// @brief The number of columns of blocks in a chunk.
+    static const int COLUMN_COUNT = Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Z;
+
+    /// @brief A struct containing the surface of a column of chunks.
+    ///
+    /// The heights are indexed by [x][z]. The coordinates have a y of zero.
+    struct ColumnStruct
+    {
+        glm::ivec3 coords;
+        int heights[COLUMN_COUNT];
+        int maxHeight;
+    };
+
+    /// @brief Gets the surface of the column of chunks at x and z.
+    ///
+    /// The column is copied out of the cache, or computed and added to it,
+    /// replacing the oldest column once the cache is full.
+    void getColumn(int x, int z, ColumnStruct &column);
+
+    /// @brief Carves the caves out of the stone listed by index in caveBlocks.
+    ///
+    /// The blocks are indexed by [x][y][z].
+    void carveCaves(glm::ivec3 coords, BlockId *blocks, const int *caveBlocks,
+        int count);
+
+    /// @brief The shape of the terrain.
+    TerrainSettingsStruct mSettings;
+
+    /// @brief The noise of the surface and of the caves.
+    Noise mSurfaceNoise;
+    Noise mCaveNoise;
+
+    /// @brief The cached columns, and the index of each one by coordinates.
+    std::vector<ColumnStruct> mColumns;
+    CoordinateMap<unsigned int> mColumnIndex;
+
+    /// @brief The slot of the column to replace next.
+    unsigned int mNextColumn;
+
+    /// @brief Guards the column cache.
+    std::mutex mColumnMutex;
+
+    /// @brief The number of chunks generated, and how many were uniform.
+    std::atomic<unsigned long> mChunks;
+    std::atomic<unsigned long> mUniformChunks;
+
+    /// @brief The number of columns found in and added to the cache.
+    std::atomic<unsigned long> mColumnHits;
+    std::atomic<unsigned long> mColumnMisses;
+
+    /// @brief The number of cave samples evaluated.
+    std::atomic<unsigned long> mCaveSamples;
+
+    /// @brief The time spent generating chunks, summed over the threads, in
+    /// nanoseconds.
+    std::atomic<unsigned long long> mTime;
+};
+
+#endif
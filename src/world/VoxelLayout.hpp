@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+/// @file VoxelLayout.hpp
+/// @brief The orders in which the blocks of a chunk can be stored.
+///
+/// This file contains the layouts that map the coordinates of a block within a
+/// box of X by Y by Z blocks to an index in memory. Code that stores blocks is
+/// templated on a layout, so the layout can be chosen at compile time.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CAMBRE_VOXEL_LAYOUT_H_
+#define _CAMBRE_VOXEL_LAYOUT_H_
+
+#include <cstdint>
+
+/// @class LinearLayout
+/// @brief The row-major layout.
+///
+/// The blocks are indexed by [x][y][z], so z is contiguous and neighbors along
+/// y and x are Z and Y * Z blocks apart.
+template <int X, int Y, int Z>
+class LinearLayout
+{
+public:
+    static const bool IS_LINEAR = true;
+
+    /// @brief The number of consecutive indices that hold consecutive blocks
+    /// along z, starting at every multiple of it.
+    static const int ROW_LENGTH = Z;
+
+    static const char *getName(void)
+    {
+        return "Linear";
+    }
+
+    static unsigned int index(int x, int y, int z)
+    {
+        return (((x * Y) + y) * Z) + z;
+    }
+
+    static void coords(unsigned int index, int &x, int &y, int &z)
+    {
+        z = index % Z;
+        y = (index / Z) % Y;
+        x = index / (Y * Z);
+    }
+};
+
+/// @class MortonLayout
+/// @brief The Morton (Z-order) layout.
+///
+/// The bits of the coordinates are interleaved, with z in the lowest bit, so
+/// that blocks that are close in all three directions are close in memory.
+/// The box must be a cube whose side is a power of two no larger than 1024.
+template <int X, int Y, int Z>
+class MortonLayout
+{
+public:
+    static const bool IS_LINEAR = false;
+
+    static_assert((X == Y) && (Y == Z), "Morton layouts require a cube");
+    static_assert((X & (X - 1)) == 0, "Morton layouts require a power of two");
+    static_assert(X <= 1024, "Morton indices must fit in 32 bits");
+
+    /// @brief The number of consecutive indices that hold consecutive blocks
+    /// along z, starting at every multiple of it. Only the lowest bit of an
+    /// index is z alone.
+    static const int ROW_LENGTH = (Z > 1) ? 2 : 1;
+
+    static const char *getName(void)
+    {
+        return "Morton";
+    }
+
+    static unsigned int index(int x, int y, int z)
+    {
+        return (spread(x) << 2) | (spread(y) << 1) | spread(z);
+    }
+
+    static void coords(unsigned int index, int &x, int &y, int &z)
+    {
+        x = compact(index >> 2);
+        y = compact(index >> 1);
+        z = compact(index);
+    }
+
+private:
+    /// @brief Inserts two zero bits between each of the lower 10 bits.
+    static uint32_t spread(uint32_t v)
+    {
+        v &= 0x3FF;
+        v = (v | (v << 16)) & 0x030000FF;
+        v = (v | (v << 8)) & 0x0300F00F;
+        v = (v | (v << 4)) & 0x030C30C3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    /// @brief Removes the two bits between each of the lower 10 bits.
+    static int compact(uint32_t v)
+    {
+        v &= 0x09249249;
+        v = (v | (v >> 2)) & 0x030C30C3;
+        v = (v | (v >> 4)) & 0x0300F00F;
+        v = (v | (v >> 8)) & 0x030000FF;
+        v = (v | (v >> 16)) & 0x000003FF;
+        return static_cast<int>(v);
+    }
+};
+
+/// @class BrickLayout
+/// @brief The tiled brick layout.
+///
+/// The box is divided into bricks of B blocks per side. The blocks of a brick
+/// are contiguous and stored row-major, and the bricks are stored row-major.
+/// Each dimension must be a multiple of B.
+template <int X, int Y, int Z, int B>
+class BrickLayout
+{
+public:
+    static const bool IS_LINEAR = false;
+
+    static_assert(((X % B) == 0) && ((Y % B) == 0) && ((Z % B) == 0),
+        "Bricks must tile the box");
+
+    /// @brief The number of consecutive indices that hold consecutive blocks
+    /// along z, starting at every multiple of it.
+    static const int ROW_LENGTH = B;
+
+    static const char *getName(void)
+    {
+        return "Brick";
+    }
+
+    static unsigned int index(int x, int y, int z)
+    {
+        const int bricksY = Y / B;
+        const int bricksZ = Z / B;
+        unsigned int brick =
+            ((((x / B) * bricksY) + (y / B)) * bricksZ) + (z / B);
+        unsigned int block = ((((x % B) * B) + (y % B)) * B) + (z % B);
+
+        return (brick * B * B * B) + block;
+    }
+
+    static void coords(unsigned int index, int &x, int &y, int &z)
+    {
+        const int bricksY = Y / B;
+        const int bricksZ = Z / B;
+        unsigned int brick = index / (B * B * B);
+        unsigned int block = index % (B * B * B);
+
+        x = ((brick / (bricksY * bricksZ)) * B) + (block / (B * B));
+        y = (((brick / bricksZ) % bricksY) * B) + ((block / B) % B);
+        z = ((brick % bricksZ) * B) + (block % B);
+    }
+};
+
+#endif